@@ -0,0 +1,85 @@
+/**
+ * @file BenchmarkStats.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef BENCHMARKSTATS_H
+#define BENCHMARKSTATS_H
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Samples of one benchmarked stage in milliseconds
+ *
+ * Median and 95th percentile are reported instead of the mean, so single
+ * outliers (scheduling, page faults) do not spoil a comparison between two
+ * releases.
+ */
+class BenchmarkStats
+{
+public:
+    /**
+     * Times one call of a function and keeps the sample
+     */
+    template <typename F>
+    void time(F function)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        m_samples.push_back(elapsed.count());
+    }
+
+    void add(double ms) { m_samples.push_back(ms); }
+    size_t count() const { return m_samples.size(); }
+
+    double percentile(double p) const
+    {
+        if (m_samples.empty()) {
+            return 0.0;
+        }
+        std::vector<double> sorted = m_samples;
+        std::sort(sorted.begin(), sorted.end());
+        size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+    double median() const { return percentile(0.5); }
+    double p95() const { return percentile(0.95); }
+    double min() const { return percentile(0.0); }
+
+    /**
+     * Writes the statistics as JSON object
+     */
+    void writeJson(std::ostream &out) const
+    {
+        out << "{\"samples\": " << count() << ", \"median_ms\": " << median()
+            << ", \"p95_ms\": " << p95() << ", \"min_ms\": " << min() << "}";
+    }
+
+private:
+    std::vector<double> m_samples;
+};
+
+/**
+ * Escapes a string for JSON output
+ */
+inline std::string jsonString(const std::string &text)
+{
+    std::string escaped = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped + "\"";
+}
+
+#endif // BENCHMARKSTATS_H
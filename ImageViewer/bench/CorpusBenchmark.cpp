@@ -0,0 +1,396 @@
+/**
+*   C++ II HS2019
+*   End-to-end throughput and accuracy on a synthetic corpus
+*
+*   Renders a reproducible corpus of pages with known text using Qt (page
+*   sizes, fonts, text sizes, rotations and line densities are drawn from a
+*   seeded random generator), then runs the whole pipeline of a profile
+*   (preprocessing, detection, grouping and recognition) over the corpus
+*   with 1, 2, 4 ... N worker threads, each owning its own engines. For
+*   every thread count a markdown table row reports pages/s, the page
+*   latency percentiles, the peak resident memory and the character
+*   accuracy against the rendered text; the accuracy is broken down by font,
+*   text size and rotation afterwards. With --save the corpus is written as
+*   PNG files with <page>.gt.txt ground truth (usable by ProfileBenchmark).
+*
+*   usage: CorpusBenchmark [-j max threads] [--pages n] [--seed n] [--profile name]
+*                          [--tessdata path] [--save dir]
+*   (run from the build directory, where the EAST model is copied to)
+*
+*   @author Simon Schweizer
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QDir>
+#include <QFont>
+#include <QFontInfo>
+#include <QFontMetrics>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+
+#include "BenchmarkStats.h"
+#include "OcrProfile.h"
+#include "Preprocessor.h"
+#include "TextAccuracy.h"
+#include "TextDetector.h"
+#include "TextGrouper.h"
+#include "TextRecognizer.h"
+
+/**
+ * Rendered page with the text it shows
+ */
+struct Page
+{
+    cv::Mat rgb;
+    std::string text;               // lines in reading order
+    std::string font;               // generic family
+    int pixelSize = 0;
+    double angle = 0.0;             // rotation of the text in degrees
+};
+
+/**
+ * Engines of one worker thread
+ */
+struct Worker
+{
+    TextDetector detector;
+    TextRecognizer recognizer;
+    explicit Worker(const DetectorSettings &settings) : detector(settings) {}
+};
+
+static const char *WORDS[] = {"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "invoice",
+    "total", "amount", "date", "order", "number", "customer", "address", "street", "city", "phone", "email",
+    "price", "quantity", "item", "description", "payment", "due", "account", "balance", "receipt", "store",
+    "open", "daily", "welcome", "special", "offer", "today", "only", "new", "sale", "home", "about", "contact",
+    "search", "login", "settings", "help", "news", "products", "services", "company", "2019", "42", "17.50",
+    "100", "CHF", "No.", "Zurich", "Bern", "Basel", "Monday", "Friday"};
+
+/**
+ * Renders the corpus, every page only depends on the seed
+ *
+ * @param count of pages
+ * @param seed of the random generator
+ * @returns rendered pages
+ */
+static std::vector<Page> renderCorpus(int count, unsigned seed)
+{
+    const QSize sizes[] = {QSize(640, 480), QSize(1024, 768), QSize(1240, 1754)};
+    const struct { const char *name; QFont::StyleHint hint; } fonts[] = {
+        {"sans", QFont::SansSerif}, {"serif", QFont::Serif}, {"mono", QFont::Monospace}};
+    const int wordCount = sizeof(WORDS) / sizeof(WORDS[0]);
+
+    std::mt19937 random(seed);
+    std::vector<Page> pages;
+    for (int p = 0; p < count; ++p) {
+        const QSize size = sizes[random() % 3];
+        const int fontIndex = random() % 3;
+        Page page;
+        page.font = fonts[fontIndex].name;
+        page.pixelSize = 14 + (int)(random() % 35);
+        page.angle = (random() % 2 == 0) ? 0.0 : ((int)(random() % 13) - 6);
+        const double spacing = 1.2 + (random() % 19) / 10.0;   // density: line pitch in line heights
+
+        QFont font;
+        font.setStyleHint(fonts[fontIndex].hint);
+        font.setFamily(fontIndex == 0 ? "Sans Serif" : fontIndex == 1 ? "Serif" : "Monospace");
+        font.setPixelSize(page.pixelSize);
+        const QFontMetrics metrics(font);
+
+        const int gray = 200 + (int)(random() % 56);
+        const int ink = (int)(random() % 60);
+        QImage image(size, QImage::Format_RGB32);
+        image.fill(QColor(gray, gray, gray));
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::TextAntialiasing);
+        painter.setFont(font);
+        painter.setPen(QColor(ink, ink, ink));
+        painter.translate(size.width() / 2.0, size.height() / 2.0);
+        painter.rotate(page.angle);
+        painter.translate(-size.width() / 2.0, -size.height() / 2.0);
+
+        // margins keep the rotated lines on the page
+        const int margin = size.width() / 10;
+        const int lineWidth = size.width() - 2 * margin;
+        for (double y = margin + metrics.ascent(); y + metrics.descent() < size.height() - margin;
+             y += spacing * metrics.height()) {
+            std::string line;
+            const int words = 1 + (int)(random() % 8);
+            for (int w = 0; w < words; ++w) {
+                std::string candidate = line + (line.empty() ? "" : " ") + WORDS[random() % wordCount];
+                if (metrics.boundingRect(QString::fromStdString(candidate)).width() > lineWidth) {
+                    break;
+                }
+                line = candidate;
+            }
+            if (line.empty()) {
+                continue;
+            }
+            painter.drawText(QPointF(margin, y), QString::fromStdString(line));
+            page.text += line + "\n";
+        }
+        painter.end();
+
+        // same input as in the GUI: 8 bit RGB
+        QImage rgb = image.convertToFormat(QImage::Format_RGB888);
+        page.rgb = cv::Mat(rgb.height(), rgb.width(), CV_8UC3, rgb.bits(), rgb.bytesPerLine()).clone();
+        pages.push_back(page);
+    }
+    return pages;
+}
+
+/**
+ * Writes the corpus as PNG files with ground truth next to them
+ *
+ * @returns false if a file could not be written
+ */
+static bool saveCorpus(const std::vector<Page> &pages, const std::string &dir)
+{
+    if (!QDir().mkpath(QString::fromStdString(dir))) {
+        return false;
+    }
+    for (size_t i = 0; i < pages.size(); ++i) {
+        std::ostringstream name;
+        name << dir << "/page_" << std::setw(3) << std::setfill('0') << i;
+        cv::Mat bgr;
+        cv::cvtColor(pages[i].rgb, bgr, cv::COLOR_RGB2BGR);
+        std::ofstream truth(name.str() + ".gt.txt");
+        truth << pages[i].text;
+        if (!cv::imwrite(name.str() + ".png", bgr) || !truth) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Resets the peak resident memory of the process (Linux only)
+ */
+static void resetPeakMemory()
+{
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+/**
+ * Peak resident memory since the last reset in MB, 0 if unknown
+ */
+static double peakMemoryMb()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::atof(line.c_str() + 6) / 1024.0;
+        }
+    }
+    return 0.0;
+}
+
+/**
+ * Runs the pipeline on one page (same steps as BatchProcessor)
+ *
+ * @param text recognized on the page
+ * @returns false if the model could not be loaded
+ */
+static bool processPage(Worker &worker, const DetectorSettings &detector, const PreprocessSettings &preprocess,
+    const Page &page, std::string &text)
+{
+    cv::Mat frame = page.rgb;
+    cv::Mat detectionFrame = page.rgb;
+    PreprocessedFrame preprocessed;
+    if (preprocess.enabled) {
+        preprocessed = Preprocessor::process(page.rgb, preprocess);
+        detectionFrame = preprocessed.gray;
+        frame = preprocessed.binary;
+    }
+    std::vector<cv::Rect> areas;
+    if (!worker.detector.detect(detectionFrame, areas)) {
+        return false;
+    }
+    areas = TextGrouper::group(areas, (TextGrouper::Mode)detector.grouping);
+    worker.recognizer.setImage(frame);
+    text = worker.recognizer.recognize(areas);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    int pageCount = 48;
+    unsigned seed = 1;
+    std::string profileName = "balanced";
+    std::string tessdata = TESSDATA_PATH;
+    std::string saveDir;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            maxThreads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--pages") == 0 && i + 1 < argc) {
+            pageCount = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned)std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profileName = argv[++i];
+        } else if (std::strcmp(argv[i], "--tessdata") == 0 && i + 1 < argc) {
+            tessdata = argv[++i];
+        } else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            saveDir = argv[++i];
+        } else {
+            std::cerr << "Unknown argument " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    maxThreads = std::max(1, maxThreads);
+
+    // fonts are rendered without a display
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    OcrProfile profile;
+    if (!OcrProfile::find(profileName, profile)) {
+        std::cerr << "Unknown profile " << profileName << std::endl;
+        return 1;
+    }
+    DetectorSettings detector;
+    PreprocessSettings preprocess;
+    profile.apply(detector, preprocess);
+    preprocess.enabled = profile.preprocess;
+
+    std::vector<Page> pages = renderCorpus(pageCount, seed);
+    if (!saveDir.empty() && !saveCorpus(pages, saveDir)) {
+        std::cerr << "Can't save the corpus to " << saveDir << std::endl;
+        return 1;
+    }
+    std::cout << pages.size() << " pages (seed " << seed << ", fonts "
+              << QFontInfo(QFont("Sans Serif")).family().toStdString() << ", "
+              << QFontInfo(QFont("Serif")).family().toStdString() << ", "
+              << QFontInfo(QFont("Monospace")).family().toStdString() << "), profile " << profile.name
+              << std::endl << std::endl;
+
+    // tesseract requires the "C" locale
+    setlocale(LC_ALL, "C");
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::cout << "| threads | pages/s | speedup | p50 ms | p90 ms | p99 ms | peak RSS MB | char accuracy |" << std::endl;
+    std::cout << "|---|---|---|---|---|---|---|---|" << std::endl;
+    double single = 0.0;
+    std::vector<double> errorRates(pages.size());
+    for (int threads : threadCounts) {
+        // the engines count to the memory of the run, their loading not to the time
+        resetPeakMemory();
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (int t = 0; t < threads; ++t) {
+            std::unique_ptr<Worker> worker(new Worker(detector));
+            if (!worker->recognizer.init(profile.dataPath(tessdata, "eng"), "eng", profile.engineMode)) {
+                std::cerr << "Failed to initialize tesseract." << std::endl;
+                return 1;
+            }
+            worker->recognizer.setPageSegModes(profile.pageSegMode, profile.areaPageSegModeFor(detector.grouping));
+            if (!worker->detector.load()) {
+                std::cerr << "Failed to load the EAST model." << std::endl;
+                return 1;
+            }
+            workers.push_back(std::move(worker));
+        }
+
+        std::atomic<int> next(0);
+        std::atomic<bool> failed(false);
+        std::mutex mutex;
+        BenchmarkStats latency;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            Worker &worker = *workers[t];
+            pool.emplace_back([&]() {
+                for (int index = next++; index < (int)pages.size() && !failed; index = next++) {
+                    std::string text;
+                    auto pageStart = std::chrono::steady_clock::now();
+                    if (!processPage(worker, detector, preprocess, pages[index], text)) {
+                        failed = true;
+                        break;
+                    }
+                    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - pageStart;
+                    double errorRate = characterErrorRate(text, pages[index].text);
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    latency.add(elapsed.count());
+                    errorRates[index] = errorRate;
+                }
+            });
+        }
+        for (std::thread &thread : pool) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (failed) {
+            std::cerr << "Detection failed." << std::endl;
+            return 1;
+        }
+
+        double errorRate = 0.0;
+        for (double rate : errorRates) {
+            errorRate += rate;
+        }
+        const double pagesPerSecond = pages.size() / elapsed.count();
+        if (threads == 1) {
+            single = pagesPerSecond;
+        }
+        const double memory = peakMemoryMb();
+        std::cout << std::fixed << "| " << threads
+                  << " | " << std::setprecision(2) << pagesPerSecond
+                  << " | " << (single > 0.0 ? pagesPerSecond / single : 0.0)
+                  << " | " << std::setprecision(1) << latency.percentile(0.5)
+                  << " | " << latency.percentile(0.9) << " | " << latency.percentile(0.99)
+                  << " | ";
+        if (memory > 0.0) {
+            std::cout << memory;
+        } else {
+            std::cout << "-";
+        }
+        std::cout << " | " << std::setprecision(3) << std::max(0.0, 1.0 - errorRate / pages.size())
+                  << " |" << std::endl;
+    }
+
+    // the recognized text does not depend on the thread count, the accuracy of the last run is broken down
+    struct Group { double errorRate = 0.0; int pages = 0; };
+    std::map<std::string, Group> groups;
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const Page &page = pages[i];
+        const std::string size = page.pixelSize < 20 ? "14-19 px" : page.pixelSize < 32 ? "20-31 px" : "32-48 px";
+        for (const std::string &key : {"font " + page.font, "size " + size,
+                                       std::string(page.angle == 0.0 ? "straight" : "rotated")}) {
+            groups[key].errorRate += errorRates[i];
+            ++groups[key].pages;
+        }
+    }
+    std::cout << std::endl << "| pages | count | char accuracy |" << std::endl << "|---|---|---|" << std::endl;
+    for (const auto &group : groups) {
+        std::cout << "| " << group.first << " | " << group.second.pages << " | " << std::setprecision(3)
+                  << std::max(0.0, 1.0 - group.second.errorRate / group.second.pages) << " |" << std::endl;
+    }
+    return 0;
+}
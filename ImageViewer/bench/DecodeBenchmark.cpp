@@ -0,0 +1,68 @@
+/**
+*   C++ II HS2019
+*   Microbenchmark of the EAST output decoder
+*
+*   Compares the scalar TextDetector::decode() with the vectorized
+*   EastDecoder on synthetic output layers of several input sizes and
+*   checks that both produce exactly the same candidates.
+*
+*   usage: DecodeBenchmark [repetitions]
+*
+*   @author Simon Schweizer
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "BenchmarkStats.h"
+#include "TextDetector.h"
+#include "EastDecoder.h"
+#include "EastLayers.h"
+
+int main(int argc, char *argv[])
+{
+    const int repetitions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+    const float threshold = 0.5f;
+    bool identical = true;
+
+    std::cout << std::setw(8) << "input" << std::setw(12) << "candidates" << std::setw(14) << "scalar us"
+              << std::setw(14) << "simd us" << std::setw(10) << "speedup" << std::endl;
+
+    EastDecoder decoder;
+    for (int size : {320, 640, 1280, 2560}) {
+        cv::Mat scores, geometry;
+        createSparseLayers(size, scores, geometry);
+
+        std::vector<cv::RotatedRect> scalarBoxes, simdBoxes;
+        std::vector<float> scalarConfidences, simdConfidences;
+
+        BenchmarkStats scalarStats, simdStats;
+        for (int r = 0; r < repetitions; ++r) {
+            scalarStats.time([&]() {
+                scalarBoxes.clear();
+                scalarConfidences.clear();
+                TextDetector::decode(scores, geometry, threshold, scalarBoxes, scalarConfidences);
+            });
+            simdStats.time([&]() { decoder.decode(scores, geometry, threshold, simdBoxes, simdConfidences); });
+        }
+        // medians in microseconds
+        const double scalar = scalarStats.median() * 1000.0;
+        const double simd = simdStats.median() * 1000.0;
+
+        // the candidates have to be bitwise identical
+        bool same = scalarBoxes.size() == simdBoxes.size()
+            && scalarConfidences == simdConfidences
+            && std::memcmp(scalarBoxes.data(), simdBoxes.data(), scalarBoxes.size() * sizeof(cv::RotatedRect)) == 0;
+        identical = identical && same;
+
+        std::cout << std::setw(8) << size << std::setw(12) << simdBoxes.size()
+                  << std::fixed << std::setprecision(1) << std::setw(14) << scalar << std::setw(14) << simd
+                  << std::setprecision(2) << std::setw(10) << (simd > 0.0 ? scalar / simd : 0.0)
+                  << (same ? "" : "  MISMATCH") << std::endl;
+    }
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file EastLayers.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef EASTLAYERS_H
+#define EASTLAYERS_H
+
+// system includes
+#include <algorithm>
+#include <random>
+
+// local includes
+#include "opencv2/core.hpp"
+
+/**
+ * Allocates the score and geometry layers of EAST for an input of size x size
+ *
+ * @returns number of cells per row and column
+ */
+inline int allocateLayers(int size, cv::Mat &scores, cv::Mat &geometry)
+{
+    const int cells = size / 4;
+    int scoreSizes[] = {1, 1, cells, cells};
+    int geometrySizes[] = {1, 5, cells, cells};
+    scores.create(4, scoreSizes, CV_32F);
+    geometry.create(4, geometrySizes, CV_32F);
+    return cells;
+}
+
+/**
+ * Creates output layers of a sparse page for an input of size x size
+ * About 3% of the cells are above the threshold, grouped in horizontal runs like text.
+ */
+inline void createSparseLayers(int size, cv::Mat &scores, cv::Mat &geometry)
+{
+    const int cells = allocateLayers(size, scores, geometry);
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> low(0.0f, 0.3f);
+    std::uniform_real_distribution<float> distance(2.0f, 40.0f);
+    std::uniform_real_distribution<float> angle(-0.2f, 0.2f);
+    std::uniform_int_distribution<int> run(0, 99);
+
+    float *s = scores.ptr<float>();
+    float *g = geometry.ptr<float>();
+    const int plane = cells * cells;
+    for (int i = 0; i < plane; ++i) {
+        s[i] = low(random);
+        for (int c = 0; c < 4; ++c) {
+            g[c * plane + i] = distance(random);
+        }
+        g[4 * plane + i] = angle(random);
+    }
+    // words: runs of 8 cells above the threshold
+    for (int i = 0; i + 8 < plane; i += 8) {
+        if (run(random) < 3) {
+            for (int k = 0; k < 8; ++k) {
+                s[i + k] = 0.5f + 0.5f * low(random);
+            }
+        }
+    }
+}
+
+/**
+ * Creates output layers of a dense page for an input of size x size
+ * Lines of words cover about a fifth of the cells, every cell of a word
+ * points to the same box (with a little noise) like the real network does.
+ */
+inline void createDenseLayers(int size, cv::Mat &scores, cv::Mat &geometry)
+{
+    const int cells = allocateLayers(size, scores, geometry);
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> low(0.0f, 0.3f);
+    std::uniform_real_distribution<float> high(0.6f, 1.0f);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> angle(-0.1f, 0.1f);
+    std::uniform_int_distribution<int> length(3, 12);
+    std::uniform_int_distribution<int> gap(1, 4);
+
+    float *s = scores.ptr<float>();
+    float *g = geometry.ptr<float>();
+    const int plane = cells * cells;
+    for (int i = 0; i < plane; ++i) {
+        s[i] = low(random);
+        for (int c = 0; c < 5; ++c) {
+            g[c * plane + i] = 0.0f;
+        }
+    }
+    // text lines on every third row of cells, words separated by small gaps
+    for (int y = 1; y + 1 < cells; y += 3) {
+        for (int x = gap(random); x < cells; ) {
+            const int words = std::min(length(random), cells - x);
+            const float wordAngle = angle(random);
+            for (int row = y; row < y + 2; ++row) {
+                for (int k = 0; k < words; ++k) {
+                    const int i = row * cells + x + k;
+                    s[i] = high(random);
+                    g[0 * plane + i] = 4.0f * (row - y) + 2.0f + noise(random);      // top
+                    g[1 * plane + i] = 4.0f * (words - k) - 2.0f + noise(random);    // right
+                    g[2 * plane + i] = 4.0f * (y + 2 - row) - 2.0f + noise(random);  // bottom
+                    g[3 * plane + i] = 4.0f * k + 2.0f + noise(random);              // left
+                    g[4 * plane + i] = wordAngle;
+                }
+            }
+            x += words + gap(random);
+        }
+    }
+}
+
+#endif // EASTLAYERS_H
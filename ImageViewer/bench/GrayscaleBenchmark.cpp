@@ -0,0 +1,60 @@
+/**
+*   C++ II HS2019
+*   Microbenchmark of the grayscale conversion
+*
+*   Compares the scalar Preprocessor::grayscaleScalar() with the SSE2 path
+*   of Preprocessor::grayscale() on random RGB frames of several sizes (odd
+*   widths included, so the scalar tail is used as well) and checks that
+*   both produce exactly the same pixels. cv::cvtColor is reported for
+*   comparison, its rounding differs.
+*
+*   usage: GrayscaleBenchmark [repetitions]
+*
+*   @author Simon Schweizer
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "BenchmarkStats.h"
+#include "Preprocessor.h"
+
+int main(int argc, char *argv[])
+{
+    const int repetitions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+    bool identical = true;
+
+    std::cout << std::setw(12) << "input" << std::setw(14) << "scalar us" << std::setw(12) << "simd us"
+              << std::setw(10) << "speedup" << std::setw(14) << "cvtColor us" << std::endl;
+
+    cv::RNG random(42);
+    for (cv::Size size : {cv::Size(640, 480), cv::Size(1001, 707), cv::Size(2480, 3508), cv::Size(4967, 7015)}) {
+        cv::Mat rgb(size, CV_8UC3);
+        random.fill(rgb, cv::RNG::UNIFORM, 0, 256);
+
+        cv::Mat scalarGray, simdGray, cvGray;
+        BenchmarkStats scalarStats, simdStats, cvStats;
+        for (int r = 0; r < repetitions; ++r) {
+            scalarStats.time([&]() { Preprocessor::grayscaleScalar(rgb, scalarGray); });
+            simdStats.time([&]() { Preprocessor::grayscale(rgb, simdGray); });
+            cvStats.time([&]() { cv::cvtColor(rgb, cvGray, cv::COLOR_RGB2GRAY); });
+        }
+        // medians in microseconds
+        const double scalar = scalarStats.median() * 1000.0;
+        const double simd = simdStats.median() * 1000.0;
+
+        // the pixels have to be identical
+        bool same = cv::countNonZero(scalarGray != simdGray) == 0;
+        identical = identical && same;
+
+        std::cout << std::setw(5) << size.width << " x " << std::setw(4) << size.height
+                  << std::fixed << std::setprecision(1) << std::setw(14) << scalar << std::setw(12) << simd
+                  << std::setprecision(2) << std::setw(10) << (simd > 0.0 ? scalar / simd : 0.0)
+                  << std::setprecision(1) << std::setw(14) << cvStats.median() * 1000.0
+                  << (same ? "" : "  MISMATCH") << std::endl;
+    }
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+/**
+*   C++ II HS2019
+*   Load generator for the local OCR service
+*
+*   Sends the given images with a fixed number of concurrent clients to a
+*   running service (ImageViewer --serve) and reports throughput, status
+*   codes and the latency percentiles seen by the clients, followed by the
+*   metrics of the service itself (queue depth, detection batch size, ...).
+*
+*   usage: LoadGenerator [--socket path | --port n] [-c clients] [-n requests] [images...]
+*
+*   @author Simon Schweizer
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "BenchmarkStats.h"
+
+/**
+ * Address of the service
+ */
+struct Endpoint
+{
+    std::string socketPath;     // Unix domain socket, used if port is 0
+    int port = 0;               // HTTP port on localhost
+};
+
+/**
+ * Opens a connection to the service
+ *
+ * @returns file descriptor, -1 on failure
+ */
+static int connectTo(const Endpoint &endpoint)
+{
+    int fd = -1;
+    if (endpoint.port > 0) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)endpoint.port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd >= 0 && connect(fd, (const sockaddr*)&address, sizeof(address)) == 0) {
+            return fd;
+        }
+    } else {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, endpoint.socketPath.c_str(), sizeof(address.sun_path) - 1);
+        if (fd >= 0 && connect(fd, (const sockaddr*)&address, sizeof(address)) == 0) {
+            return fd;
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    return -1;
+}
+
+/**
+ * Sends one request and reads the whole response (the service closes the connection)
+ *
+ * @param endpoint of the service
+ * @param method GET or POST
+ * @param path of the request
+ * @param body sent with the request
+ * @param response body of the response
+ * @returns HTTP status code, 0 if the service could not be reached
+ */
+static int request(const Endpoint &endpoint, const std::string &method, const std::string &path,
+    const std::string &body, std::string &response)
+{
+    int fd = connectTo(endpoint);
+    if (fd < 0) {
+        return 0;
+    }
+    std::string message = method + " " + path + " HTTP/1.0\r\nHost: localhost\r\n"
+        + "Content-Type: application/octet-stream\r\nContent-Length: " + std::to_string(body.size())
+        + "\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < message.size()) {
+        ssize_t n = send(fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            close(fd);
+            return 0;
+        }
+        sent += (size_t)n;
+    }
+
+    std::string received;
+    char buffer[16384];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        received.append(buffer, (size_t)n);
+    }
+    close(fd);
+
+    size_t headerEnd = received.find("\r\n\r\n");
+    size_t space = received.find(' ');
+    if (headerEnd == std::string::npos || space == std::string::npos) {
+        return 0;
+    }
+    response = received.substr(headerEnd + 4);
+    return std::atoi(received.c_str() + space + 1);
+}
+
+int main(int argc, char *argv[])
+{
+    Endpoint endpoint;
+    endpoint.socketPath = "/tmp/imageviewer-ocr.sock";
+    int clients = 4;
+    int requests = 100;
+    std::vector<std::string> images;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            endpoint.socketPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            endpoint.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            clients = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            requests = std::max(1, std::atoi(argv[++i]));
+        } else {
+            images.push_back(argv[i]);
+        }
+    }
+    if (images.empty()) {
+        images = {TEST_IMAGES_DIR "/homepage.png", TEST_IMAGES_DIR "/receipt2_g.png",
+                  TEST_IMAGES_DIR "/storefront5.png"};
+    }
+
+    // the encoded files are sent as they are, the service decodes them
+    std::vector<std::string> bodies;
+    for (const std::string &path : images) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Can't read image " << path << std::endl;
+            return 1;
+        }
+        std::stringstream content;
+        content << file.rdbuf();
+        bodies.push_back(content.str());
+    }
+
+    std::atomic<int> next(0);
+    std::mutex mutex;
+    BenchmarkStats latency;
+    std::map<int, int> statusCounts;        // 0: connection failed
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&]() {
+            for (int index = next++; index < requests; index = next++) {
+                std::string response;
+                auto sent = std::chrono::steady_clock::now();
+                int status = request(endpoint, "POST", "/ocr", bodies[index % bodies.size()], response);
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - sent;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                ++statusCounts[status];
+                if (status == 200) {
+                    latency.add(elapsed.count());
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << requests << " requests, " << clients << " clients in " << elapsed.count() << " s, "
+              << std::setprecision(2) << latency.count() / elapsed.count() << " images/s" << std::endl;
+    std::cout << "status:";
+    for (const auto &count : statusCounts) {
+        std::cout << " " << (count.first == 0 ? std::string("unreachable") : std::to_string(count.first))
+                  << "=" << count.second;
+    }
+    std::cout << std::endl;
+    std::cout << std::setprecision(1) << "latency ms: p50 " << latency.percentile(0.5)
+              << ", p90 " << latency.percentile(0.9) << ", p99 " << latency.percentile(0.99)
+              << ", max " << latency.percentile(1.0) << std::endl;
+
+    std::string metrics;
+    if (request(endpoint, "GET", "/metrics", "", metrics) != 200) {
+        std::cerr << "Can't read the service metrics." << std::endl;
+        return 1;
+    }
+    std::cout << "service metrics: " << metrics << std::endl;
+    return statusCounts.count(0) > 0 ? 1 : 0;
+}
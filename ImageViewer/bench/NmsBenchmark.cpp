@@ -0,0 +1,82 @@
+/**
+*   C++ II HS2019
+*   Microbenchmark of the non-maximum suppression
+*
+*   Decodes synthetic EAST output layers of a dense page (many words, each
+*   seen by every cell it covers, so the candidates of a word overlap
+*   heavily) and compares cv::dnn::NMSBoxes with the grid indexed
+*   RotatedNms, which has to keep exactly the same boxes in the same order.
+*   The locality-aware merge prior suppression is timed as well, it changes
+*   the result and is reported with the number of boxes it keeps.
+*
+*   usage: NmsBenchmark [repetitions]
+*
+*   @author Simon Schweizer
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "opencv2/dnn.hpp"
+#include "BenchmarkStats.h"
+#include "EastDecoder.h"
+#include "EastLayers.h"
+#include "RotatedNms.h"
+
+int main(int argc, char *argv[])
+{
+    const int repetitions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+    const float confThreshold = 0.5f;
+    const float nmsThreshold = 0.4f;
+    bool identical = true;
+
+    std::cout << std::setw(8) << "input" << std::setw(12) << "candidates" << std::setw(8) << "kept"
+              << std::setw(14) << "NMSBoxes us" << std::setw(12) << "grid us" << std::setw(10) << "speedup"
+              << std::setw(12) << "merge us" << std::setw(8) << "kept" << std::endl;
+
+    EastDecoder decoder;
+    RotatedNms nms;
+    for (int size : {320, 640, 1280, 2560}) {
+        cv::Mat scores, geometry;
+        createDenseLayers(size, scores, geometry);
+        std::vector<cv::RotatedRect> boxes;
+        std::vector<float> confidences;
+        decoder.decode(scores, geometry, confThreshold, boxes, confidences);
+
+        std::vector<int> reference, indices;
+        BenchmarkStats brute, grid, merge;
+        for (int r = 0; r < repetitions; ++r) {
+            brute.time([&]() { cv::dnn::NMSBoxes(boxes, confidences, confThreshold, nmsThreshold, reference); });
+            grid.time([&]() { nms.suppress(boxes, confidences, confThreshold, nmsThreshold, indices); });
+        }
+
+        // the same boxes have to survive, in the same order
+        bool same = reference == indices;
+        identical = identical && same;
+
+        // locality-aware merge (on a copy, it replaces the candidates)
+        std::vector<int> merged;
+        for (int r = 0; r < repetitions; ++r) {
+            merge.time([&]() {
+                std::vector<cv::RotatedRect> mergedBoxes = boxes;
+                std::vector<float> mergedConfidences = confidences;
+                RotatedNms::mergeLocal(mergedBoxes, mergedConfidences, nmsThreshold);
+                nms.suppress(mergedBoxes, mergedConfidences, confThreshold, nmsThreshold, merged);
+            });
+        }
+
+        // medians in microseconds
+        const double bruteUs = brute.median() * 1000.0;
+        const double gridUs = grid.median() * 1000.0;
+
+        std::cout << std::setw(8) << size << std::setw(12) << boxes.size() << std::setw(8) << indices.size()
+                  << std::fixed << std::setprecision(1) << std::setw(14) << bruteUs << std::setw(12) << gridUs
+                  << std::setprecision(2) << std::setw(10) << (gridUs > 0.0 ? bruteUs / gridUs : 0.0)
+                  << std::setprecision(1) << std::setw(12) << merge.median() * 1000.0 << std::setw(8) << merged.size()
+                  << (same ? "" : "  MISMATCH") << std::endl;
+    }
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+/**
+*   C++ II HS2019
+*   Throughput and accuracy of the OCR profiles
+*
+*   Runs the whole pipeline (preprocessing, detection, grouping and
+*   recognition of the areas) with every profile on the test images and
+*   prints a markdown table: median time per image, throughput, recognition
+*   calls, mean Tesseract word confidence and, if a ground truth
+*   <image>.gt.txt lies next to an image, the character error rate.
+*
+*   usage: ProfileBenchmark [-n repetitions] [--tessdata path] [images...]
+*   (run from the build directory, where the EAST model is copied to)
+*
+*   @author Simon Schweizer
+*/
+
+#include <algorithm>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BenchmarkStats.h"
+#include "OcrProfile.h"
+#include "Preprocessor.h"
+#include "TextAccuracy.h"
+#include "TextDetector.h"
+#include "TextGrouper.h"
+#include "TextRecognizer.h"
+
+/**
+ * Result of one profile on one image
+ */
+struct Run
+{
+    BenchmarkStats ms;
+    int calls = 0;
+    double confidence = 0.0;
+    double errorRate = -1.0;        // -1: no ground truth
+};
+
+/**
+ * Runs the pipeline of one profile on one image
+ *
+ * @returns false if the model could not be loaded
+ */
+static bool runProfile(const OcrProfile &profile, const cv::Mat &rgb, const std::string &groundTruth,
+    int repetitions, TextRecognizer &recognizer, Run &run)
+{
+    DetectorSettings detector;
+    PreprocessSettings preprocess;
+    profile.apply(detector, preprocess);
+    preprocess.enabled = profile.preprocess;
+    TextDetector textDetector(detector);
+
+    std::string text;
+    for (int r = 0; r < repetitions; ++r) {
+        bool loaded = true;
+        run.ms.time([&]() {
+            cv::Mat frame = rgb;
+            cv::Mat detectionFrame = rgb;
+            PreprocessedFrame preprocessed;
+            if (preprocess.enabled) {
+                preprocessed = Preprocessor::process(rgb, preprocess);
+                detectionFrame = preprocessed.gray;
+                frame = preprocessed.binary;
+            }
+            std::vector<cv::Rect> areas;
+            loaded = textDetector.detect(detectionFrame, areas);
+            areas = TextGrouper::group(areas, (TextGrouper::Mode)detector.grouping);
+
+            recognizer.setImage(frame);
+            text.clear();
+            double confidence = 0.0;
+            for (const cv::Rect &area : areas) {
+                text += recognizer.recognize(area) + "\n";
+                confidence += recognizer.meanConfidence();
+            }
+            run.calls = (int)areas.size();
+            run.confidence = areas.empty() ? 0.0 : confidence / areas.size();
+        });
+        if (!loaded) {
+            return false;
+        }
+    }
+
+    if (!groundTruth.empty()) {
+        run.errorRate = characterErrorRate(text, groundTruth);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int repetitions = 3;
+    std::string tessdata = TESSDATA_PATH;
+    std::vector<std::string> images;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--tessdata") == 0 && i + 1 < argc) {
+            tessdata = argv[++i];
+        } else {
+            images.push_back(argv[i]);
+        }
+    }
+    if (images.empty()) {
+        images = {TEST_IMAGES_DIR "/homepage.png", TEST_IMAGES_DIR "/receipt2_g.png",
+                  TEST_IMAGES_DIR "/storefront5.png"};
+    }
+
+    // tesseract requires the "C" locale
+    setlocale(LC_ALL, "C");
+
+    // same input as in the GUI: 8 bit RGB
+    std::vector<cv::Mat> frames;
+    std::vector<std::string> groundTruths;
+    for (const std::string &path : images) {
+        cv::Mat frame = cv::imread(path, cv::IMREAD_COLOR);
+        if (frame.empty()) {
+            std::cerr << "Can't read image " << path << std::endl;
+            return 1;
+        }
+        cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
+        frames.push_back(frame);
+
+        std::ifstream file(path.substr(0, path.find_last_of('.')) + ".gt.txt");
+        std::stringstream truth;
+        truth << file.rdbuf();
+        groundTruths.push_back(file ? truth.str() : std::string());
+    }
+
+    std::cout << "| profile | tessdata | ms/image (median) | images/s | calls | confidence | CER |" << std::endl;
+    std::cout << "|---|---|---|---|---|---|---|" << std::endl;
+    for (const OcrProfile &profile : OcrProfile::all()) {
+        const std::string dataPath = profile.dataPath(tessdata, "eng");
+        TextRecognizer recognizer;
+        if (!recognizer.init(dataPath, "eng", profile.engineMode)) {
+            std::cerr << "Failed to initialize tesseract for " << profile.name << std::endl;
+            return 1;
+        }
+        recognizer.setPageSegModes(profile.pageSegMode, profile.areaPageSegMode);
+
+        double ms = 0.0;
+        int calls = 0;
+        double confidence = 0.0;
+        double errorRate = 0.0;
+        int truths = 0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            Run run;
+            if (!runProfile(profile, frames[i], groundTruths[i], repetitions, recognizer, run)) {
+                std::cerr << "Failed to load the EAST model." << std::endl;
+                return 1;
+            }
+            ms += run.ms.median();
+            calls += run.calls;
+            confidence += run.confidence;
+            if (run.errorRate >= 0.0) {
+                errorRate += run.errorRate;
+                ++truths;
+            }
+        }
+
+        const double perImage = ms / frames.size();
+        std::cout << std::fixed << "| " << profile.name << " | " << dataPath.substr(dataPath.find_last_of('/') + 1)
+                  << " | " << std::setprecision(1) << perImage
+                  << " | " << std::setprecision(2) << (perImage > 0.0 ? 1000.0 / perImage : 0.0)
+                  << " | " << calls
+                  << " | " << std::setprecision(1) << confidence / frames.size()
+                  << " | ";
+        if (truths > 0) {
+            std::cout << std::setprecision(3) << errorRate / truths;
+        } else {
+            std::cout << "-";
+        }
+        std::cout << " |" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+*   C++ II HS2019
+*   Scaling of the parallel text area recognition
+*
+*   Detects the text areas of every image and recognizes them with
+*   1..N Tesseract instances, reporting time and speedup per thread count.
+*   Then the boxes are grouped into words, lines and paragraphs and
+*   recognized by one instance, reporting the recognition calls saved and
+*   the time (grouping included) compared with single words.
+*
+*   usage: RegionBenchmark [max threads] [images...]
+*
+*   @author Simon Schweizer
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <clocale>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TextDetector.h"
+#include "TextGrouper.h"
+#include "ParallelRecognizer.h"
+
+int main(int argc, char *argv[])
+{
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : (int)std::thread::hardware_concurrency();
+    maxThreads = std::max(1, maxThreads);
+
+    std::vector<std::string> images;
+    for (int i = 2; i < argc; ++i) {
+        images.push_back(argv[i]);
+    }
+    if (images.empty()) {
+        images = {TEST_IMAGES_DIR "/homepage.png", TEST_IMAGES_DIR "/receipt2_g.png",
+                  TEST_IMAGES_DIR "/storefront5.png"};
+    }
+
+    // tesseract requires the "C" locale
+    setlocale(LC_ALL, "C");
+
+    TextDetector detector;
+    ParallelRecognizer recognizer(maxThreads);
+    recognizer.setMinAreasPerThread(1);
+    if (!recognizer.init()) {
+        std::cerr << "Failed to initialize tesseract." << std::endl;
+        return 1;
+    }
+
+    for (const std::string &path : images) {
+        // same input as in the GUI: 8 bit RGB
+        cv::Mat frame = cv::imread(path, cv::IMREAD_COLOR);
+        if (frame.empty()) {
+            std::cerr << "Can't read image " << path << std::endl;
+            continue;
+        }
+        cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
+
+        std::vector<cv::Rect> areas;
+        if (!detector.detect(frame, areas)) {
+            std::cerr << "Failed to load the EAST model." << std::endl;
+            return 1;
+        }
+
+        std::cout << path << ": " << areas.size() << " areas" << std::endl;
+        std::cout << std::setw(8) << "threads" << std::setw(12) << "ms" << std::setw(10) << "speedup" << std::endl;
+
+        double single = 0.0;
+        for (int threads = 1; threads <= maxThreads; ++threads) {
+            auto start = std::chrono::steady_clock::now();
+            recognizer.recognize(frame, areas, [](int, const std::string &) { return true; }, threads);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+            if (threads == 1) {
+                single = elapsed.count();
+            }
+            std::cout << std::setw(8) << threads << std::setw(12) << std::fixed << std::setprecision(1)
+                      << elapsed.count() << std::setw(10) << std::setprecision(2)
+                      << (elapsed.count() > 0.0 ? single / elapsed.count() : 0.0) << std::endl;
+        }
+
+        std::cout << std::setw(12) << "grouping" << std::setw(8) << "areas" << std::setw(8) << "saved"
+                  << std::setw(12) << "ms" << std::setw(10) << "speedup" << std::endl;
+        const char *names[] = {"words", "lines", "paragraphs"};
+        double words = 0.0;
+        for (int mode = TextGrouper::Words; mode <= TextGrouper::Paragraphs; ++mode) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<cv::Rect> grouped = TextGrouper::group(areas, (TextGrouper::Mode)mode);
+            recognizer.recognize(frame, grouped, [](int, const std::string &) { return true; }, 1);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+            if (mode == TextGrouper::Words) {
+                words = elapsed.count();
+            }
+            std::cout << std::setw(12) << names[mode] << std::setw(8) << grouped.size()
+                      << std::setw(8) << areas.size() - grouped.size() << std::setw(12) << std::fixed
+                      << std::setprecision(1) << elapsed.count() << std::setw(10) << std::setprecision(2)
+                      << (elapsed.count() > 0.0 ? words / elapsed.count() : 0.0) << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,250 @@
+/**
+*   C++ II HS2019
+*   Microbenchmark of the detection and recognition stages
+*
+*   Times every stage of the OCR pipeline on its own for the test images:
+*   QImage to cv::Mat conversion, blobFromImage, the EAST forward pass,
+*   decoding of the output layers, NMSBoxes (and the grid indexed RotatedNms
+*   with the same result) and the recognition of every
+*   detected area. The preprocessing steps (grayscale, binarization, skew
+*   estimation) are timed as well, together with the recognition of the
+*   same areas on the binarized frame and the size of both recognition
+*   inputs. Median and p95 are written as JSON (stdout or a file), so the
+*   results of two releases can be diffed.
+*
+*   usage: StageBenchmark [-n repetitions] [-o result.json] [images...]
+*   (run from the build directory, where the EAST model is copied to)
+*
+*   @author Simon Schweizer
+*/
+
+#include <algorithm>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QImage>
+
+#include "BenchmarkStats.h"
+#include "EastDecoder.h"
+#include "Preprocessor.h"
+#include "RotatedNms.h"
+#include "SharedImage.h"
+#include "TextDetector.h"
+#include "TextRecognizer.h"
+
+#ifndef BENCHMARK_BUILD_TYPE
+#define BENCHMARK_BUILD_TYPE "unknown"
+#endif
+
+// order of the stages in the output
+static const char *STAGES[] = {"qimage_to_mat", "blob_from_image", "forward", "decode", "nms_boxes", "nms_grid", "recognize_area",
+    "grayscale", "grayscale_cvtcolor", "binarize", "estimate_skew", "recognize_area_binary"};
+
+/**
+ * Times all stages for one image
+ *
+ * @returns false if the image or the model could not be loaded
+ */
+static bool benchmarkImage(const std::string &path, int repetitions, cv::dnn::Net &net,
+    TextRecognizer &recognizer, std::map<std::string, BenchmarkStats> &stats, int &areaCount,
+    size_t &rgbBytes, size_t &binaryBytes)
+{
+    const DetectorSettings settings;
+    const std::vector<std::string> layerNames = {"feature_fusion/Conv_7/Sigmoid", "feature_fusion/concat_3"};
+
+    QImage file(QString::fromStdString(path));
+    if (file.isNull()) {
+        std::cerr << "Can't read image " << path << std::endl;
+        return false;
+    }
+
+    // QImage (any format) to 8 bit RGB cv::Mat as used by the pipeline
+    cv::Mat frame;
+    for (int r = 0; r < repetitions; ++r) {
+        stats["qimage_to_mat"].time([&]() {
+            SharedImage image(file);
+            frame = image.mat().clone();    // the clone keeps the frame valid after the loop
+        });
+    }
+
+    cv::Mat blob;
+    for (int r = 0; r < repetitions; ++r) {
+        stats["blob_from_image"].time([&]() {
+            cv::dnn::blobFromImage(frame, blob, 1.0, cv::Size(settings.inputWidth, settings.inputHeight),
+                cv::Scalar(123.68, 116.78, 103.94), true, false);
+        });
+    }
+
+    // the first pass initializes the network and is not counted
+    std::vector<cv::Mat> outs;
+    net.setInput(blob);
+    net.forward(outs, layerNames);
+    for (int r = 0; r < repetitions; ++r) {
+        stats["forward"].time([&]() {
+            net.setInput(blob);
+            net.forward(outs, layerNames);
+        });
+    }
+
+    EastDecoder decoder;
+    std::vector<cv::RotatedRect> boxes;
+    std::vector<float> confidences;
+    for (int r = 0; r < repetitions; ++r) {
+        stats["decode"].time([&]() {
+            decoder.decode(outs[0], outs[1], settings.confThreshold, boxes, confidences);
+        });
+    }
+
+    std::vector<int> indices;
+    for (int r = 0; r < repetitions; ++r) {
+        stats["nms_boxes"].time([&]() {
+            cv::dnn::NMSBoxes(boxes, confidences, settings.confThreshold, settings.nmsThreshold, indices);
+        });
+    }
+    RotatedNms nms;
+    std::vector<int> gridIndices;
+    for (int r = 0; r < repetitions; ++r) {
+        stats["nms_grid"].time([&]() {
+            nms.suppress(boxes, confidences, settings.confThreshold, settings.nmsThreshold, gridIndices);
+        });
+    }
+
+    // areas in frame coordinates (same as TextDetector)
+    std::vector<cv::Rect> areas;
+    cv::Point2f ratio((float)frame.cols / settings.inputWidth, (float)frame.rows / settings.inputHeight);
+    for (int index : indices) {
+        cv::Rect area = boxes[index].boundingRect();
+        area = cv::Rect(cv::Point(area.x * ratio.x, area.y * ratio.y),
+            cv::Size(area.width * ratio.x, area.height * ratio.y)) & cv::Rect(0, 0, frame.cols, frame.rows);
+        if (area.area() > 0) {
+            areas.push_back(area);
+        }
+    }
+    areaCount = (int)areas.size();
+
+    // recognition is slow, every area is recognized once per repetition
+    recognizer.setImage(frame);
+    for (int r = 0; r < repetitions; ++r) {
+        for (const cv::Rect &area : areas) {
+            stats["recognize_area"].time([&]() {
+                recognizer.recognize(area);
+            });
+        }
+    }
+
+    // preprocessing, the own vectorized grayscale conversion is compared with cvtColor
+    const PreprocessSettings preprocess;
+    cv::Mat gray;
+    cv::Mat binary;
+    for (int r = 0; r < repetitions; ++r) {
+        stats["grayscale"].time([&]() {
+            Preprocessor::grayscale(frame, gray);
+        });
+        stats["grayscale_cvtcolor"].time([&]() {
+            cv::cvtColor(frame, gray, cv::COLOR_RGB2GRAY);
+        });
+        stats["binarize"].time([&]() {
+            Preprocessor::binarize(gray, binary, preprocess.blockSize, preprocess.offset);
+        });
+        stats["estimate_skew"].time([&]() {
+            Preprocessor::estimateSkew(gray, preprocess.maxSkew);
+        });
+    }
+
+    // the same areas on the binarized frame (not deskewed, so the coordinates match)
+    recognizer.setImage(binary);
+    for (int r = 0; r < repetitions; ++r) {
+        for (const cv::Rect &area : areas) {
+            stats["recognize_area_binary"].time([&]() {
+                recognizer.recognize(area);
+            });
+        }
+    }
+    rgbBytes = frame.total() * frame.elemSize();
+    binaryBytes = binary.total() * binary.elemSize();
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int repetitions = 20;
+    std::string outputPath;
+    std::vector<std::string> images;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            images.push_back(argv[i]);
+        }
+    }
+    if (images.empty()) {
+        images = {TEST_IMAGES_DIR "/homepage.png", TEST_IMAGES_DIR "/receipt2_g.png",
+                  TEST_IMAGES_DIR "/storefront5.png"};
+    }
+
+    // tesseract requires the "C" locale
+    setlocale(LC_ALL, "C");
+
+    cv::dnn::Net net = cv::dnn::readNet(DetectorSettings().model);
+    if (net.empty()) {
+        std::cerr << "Failed to load the EAST model." << std::endl;
+        return 1;
+    }
+    TextRecognizer recognizer;
+    if (!recognizer.init()) {
+        std::cerr << "Failed to initialize tesseract." << std::endl;
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath);
+        if (!file) {
+            std::cerr << "Can't write " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = outputPath.empty() ? std::cout : file;
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\n  \"build_type\": " << jsonString(BENCHMARK_BUILD_TYPE)
+        << ",\n  \"opencv\": " << jsonString(CV_VERSION)
+        << ",\n  \"cv_threads\": " << cv::getNumThreads()
+        << ",\n  \"repetitions\": " << repetitions
+        << ",\n  \"images\": [";
+
+    bool ok = true;
+    bool first = true;
+    for (const std::string &path : images) {
+        std::map<std::string, BenchmarkStats> stats;
+        int areaCount = 0;
+        size_t rgbBytes = 0;
+        size_t binaryBytes = 0;
+        if (!benchmarkImage(path, repetitions, net, recognizer, stats, areaCount, rgbBytes, binaryBytes)) {
+            ok = false;
+            continue;
+        }
+
+        out << (first ? "\n" : ",\n") << "    {\"image\": " << jsonString(path.substr(path.find_last_of('/') + 1))
+            << ", \"areas\": " << areaCount << ", \"rgb_bytes\": " << rgbBytes
+            << ", \"binary_bytes\": " << binaryBytes << ", \"stages\": {";
+        for (size_t s = 0; s < sizeof(STAGES) / sizeof(STAGES[0]); ++s) {
+            out << (s == 0 ? "\n" : ",\n") << "      " << jsonString(STAGES[s]) << ": ";
+            stats[STAGES[s]].writeJson(out);
+        }
+        out << "\n    }}";
+        first = false;
+        std::cerr << path << " done" << std::endl;
+    }
+    out << "\n  ]\n}\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file TextAccuracy.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef TEXTACCURACY_H
+#define TEXTACCURACY_H
+
+// system includes
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Collapses all whitespace to single blanks, OCR output differs mostly in line breaks
+ */
+inline std::string normalized(const std::string &text)
+{
+    std::istringstream in(text);
+    std::string word;
+    std::string result;
+    while (in >> word) {
+        result += result.empty() ? word : " " + word;
+    }
+    return result;
+}
+
+/**
+ * Levenshtein distance of two byte strings
+ */
+inline size_t editDistance(const std::string &a, const std::string &b)
+{
+    std::vector<size_t> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j) {
+        row[j] = j;
+    }
+    for (size_t i = 1; i <= a.size(); ++i) {
+        size_t diagonal = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= b.size(); ++j) {
+            size_t above = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+/**
+ * Character error rate of a recognized text (edit distance per character of the expected text)
+ */
+inline double characterErrorRate(const std::string &recognized, const std::string &expected)
+{
+    const std::string truth = normalized(expected);
+    return (double)editDistance(normalized(recognized), truth) / std::max<size_t>(1, truth.size());
+}
+
+#endif // TEXTACCURACY_H
@@ -0,0 +1,408 @@
+// system includes
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+// local includes
+#include "BatchProcessor.h"
+#include "BoundedQueue.h"
+#include "DocumentReader.h"
+#include "LayoutWriter.h"
+#include "SharedImage.h"
+#include "Tracer.h"
+
+BatchProcessor::BatchProcessor(const BatchOptions &options) : m_options(options), m_boxCount(0), m_areaCount(0)
+{
+}
+
+BatchProcessor::~BatchProcessor()
+{
+}
+
+/**
+ * Runs OCR on all input images, distributed over the worker pool
+ *
+ * @returns 0 if all images were processed, 1 otherwise
+ */
+int BatchProcessor::run()
+{
+    QStringList images = collectImages();
+    if (images.isEmpty()) {
+        std::cerr << "No images found." << std::endl;
+        return 1;
+    }
+
+    if (!m_options.outputDir.isEmpty() && !QDir().mkpath(m_options.outputDir)) {
+        std::cerr << "Can't create output directory " << m_options.outputDir.toStdString() << std::endl;
+        return 1;
+    }
+
+    // two workers must never write the same file (same name in several input directories with -o),
+    // an image listed twice is processed once
+    QHash<QString, QString> outputs;
+    QStringList unique;
+    for (const QString &image : images) {
+        const QString output = QFileInfo(outputPath(image)).absoluteFilePath();
+        if (outputs.contains(output)) {
+            if (QFileInfo(outputs.value(output)).canonicalFilePath() == QFileInfo(image).canonicalFilePath()) {
+                continue;
+            }
+            std::cerr << "Both " << outputs.value(output).toStdString() << " and " << image.toStdString()
+                      << " would be written to " << output.toStdString() << std::endl;
+            return 1;
+        }
+        outputs.insert(output, image);
+        unique << image;
+    }
+    images = unique;
+
+    // never start more workers than there are images
+    int threadCount = std::max(1, std::min(m_options.threads, images.size()));
+    if (!createWorkers(threadCount)) {
+        return 1;
+    }
+
+    // detection requests of all workers are batched
+    if (m_options.detectAreas && m_options.detectBatch > 1) {
+        m_batcher.reset(new DetectionBatcher(m_options.detector, m_options.detectBatch, m_options.batchLatencyMs));
+        if (!m_batcher->start()) {
+            std::cerr << "Failed to load " << m_options.detector.model << std::endl;
+            return 1;
+        }
+        if (m_options.detector.warmUp) {
+            std::cout << "warm-up forward " << m_batcher->detector().warmUpMs() << " ms" << std::endl;
+        }
+    } else if (m_options.detectAreas && m_options.detector.warmUp) {
+        std::cout << "warm-up forward " << m_workers[0]->detector.warmUpMs() << " ms" << std::endl;
+    }
+
+    std::atomic<int> next(0);       // index of the next image to be processed
+    std::atomic<int> failed(0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // every worker pulls the next image until all are done
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        Worker &worker = *m_workers[i];
+        threads.emplace_back([this, &worker, &images, &next, &failed]() {
+            for (int index = next++; index < images.size(); index = next++) {
+                if (!processImage(worker, images.at(index))) {
+                    ++failed;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double seconds = elapsed.count();
+
+    if (m_batcher) {
+        m_batcher->stop();
+        std::cout << "average detection batch size " << m_batcher->averageBatchSize()
+                  << ", average forward " << m_batcher->detector().averageForwardMs() << " ms" << std::endl;
+    } else if (m_options.detectAreas) {
+        double forwardMs = 0.0;
+        for (const std::unique_ptr<Worker> &worker : m_workers) {
+            forwardMs += worker->detector.averageForwardMs();
+        }
+        std::cout << "average forward " << forwardMs / m_workers.size() << " ms" << std::endl;
+    }
+    if (m_options.detectAreas) {
+        std::cout << m_boxCount.load() << " boxes grouped into " << m_areaCount.load() << " areas ("
+                  << m_boxCount.load() - m_areaCount.load() << " recognition calls saved)" << std::endl;
+    }
+
+    std::cout << images.size() << " images (" << failed.load() << " failed) with "
+              << threadCount << " threads in " << seconds << " s, "
+              << (seconds > 0.0 ? images.size() / seconds : 0.0) << " images/sec" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+/**
+ * Resolves the inputs into a list of image files
+ * Directories are searched for images, text files are read as list of images (one per line).
+ *
+ * @returns paths of all images
+ */
+QStringList BatchProcessor::collectImages() const
+{
+    const QStringList imageFilters = DocumentReader::nameFilters();
+    QStringList images;
+
+    for (const QString &input : m_options.inputs) {
+        QFileInfo info(input);
+        if (info.isDir()) {
+            QDirIterator it(input, imageFilters, QDir::Files);
+            QStringList found;
+            while (it.hasNext()) {
+                found << it.next();
+            }
+            found.sort();
+            images << found;
+        } else if (info.suffix().compare("txt", Qt::CaseInsensitive) == 0) {
+            QFile list(input);
+            if (!list.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                std::cerr << "Can't read file list " << input.toStdString() << std::endl;
+                continue;
+            }
+            QTextStream in(&list);
+            while (!in.atEnd()) {
+                QString line = in.readLine().trimmed();
+                if (!line.isEmpty()) {
+                    images << line;
+                }
+            }
+        } else if (info.isFile()) {
+            images << input;
+        } else {
+            std::cerr << "No such file or directory: " << input.toStdString() << std::endl;
+        }
+    }
+    return images;
+}
+
+/**
+ * Creates the pool of engines, one Tesseract API and one EAST network per worker
+ * The engines are initialized sequentially, before any thread is started.
+ *
+ * @param count of workers
+ * @returns false if an engine could not be initialized
+ */
+bool BatchProcessor::createWorkers(int count)
+{
+    m_workers.clear();
+    for (int i = 0; i < count; ++i) {
+        std::unique_ptr<Worker> worker(new Worker(m_options.detector));
+        const OcrProfile &profile = m_options.profile;
+        if (!worker->recognizer.init(profile.dataPath(m_options.tessdata, m_options.language),
+                m_options.language, profile.engineMode)) {
+            std::cerr << "Failed to initialize tesseract." << std::endl;
+            return false;
+        }
+        worker->recognizer.setPageSegModes(profile.pageSegMode,
+            profile.areaPageSegModeFor(m_options.detector.grouping));
+        bool ownDetector = m_options.detectAreas && m_options.detectBatch <= 1;
+        if (ownDetector && !worker->detector.load()) {
+            std::cerr << "Failed to load " << m_options.detector.model << std::endl;
+            return false;
+        }
+        m_workers.push_back(std::move(worker));
+    }
+    return true;
+}
+
+/**
+ * Performs OCR on a single image or all pages of a document and writes the text file
+ * The pages of a document are decoded by a second thread, at most PIPELINE_DEPTH
+ * pages ahead of the recognition. Pages are separated by a form feed.
+ *
+ * @param worker owning the engines to be used
+ * @param path of the image or document
+ * @returns false if the file could not be processed
+ */
+bool BatchProcessor::processImage(Worker &worker, const QString &path)
+{
+    DocumentReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Can't read image " << path.toStdString() << std::endl;
+        return false;
+    }
+
+    // word boxes are streamed into the file page by page, plain text is written at the end
+    QFile file(outputPath(path));
+    LayoutWriter::Format format;
+    std::unique_ptr<LayoutWriter> writer;
+    if (LayoutWriter::formatOf(file.fileName(), format)) {
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cerr << "Can't save text " << file.fileName().toStdString() << std::endl;
+            return false;
+        }
+        writer.reset(new LayoutWriter(&file, format));
+        writer->begin(path);
+    }
+
+    struct Page {
+        int index;
+        SharedImage image;
+    };
+    BoundedQueue<Page> pages(PIPELINE_DEPTH);
+    std::atomic<int> unreadPage(-1);
+    auto decodePages = [&reader, &pages, &unreadPage]() {
+        for (int index = 0; index < reader.pageCount(); ++index) {
+            Page page;
+            page.index = index;
+            {
+                // conversion to 8 bit RGB allows any input format (same as in the GUI)
+                TraceSpan span("load_image", index);
+                page.image = reader.page(index);
+            }
+            if (page.image.isNull()) {
+                unreadPage = index;
+                break;
+            }
+            // waits while the recognition is PIPELINE_DEPTH pages behind
+            if (!pages.push(std::move(page))) {
+                break;
+            }
+        }
+        pages.close();
+    };
+
+    // the next pages of a document are decoded while the current one is recognized
+    std::thread decoder;
+    if (reader.pageCount() > 1) {
+        decoder = std::thread([&decodePages]() {
+            Tracer::instance().setThreadName("page decoder");
+            decodePages();
+        });
+    } else {
+        decodePages();      // a single page fits into the queue
+    }
+
+    std::string text;
+    bool complete = true;
+    Page page;
+    while (pages.pop(page)) {
+        if (page.index > 0) {
+            text += '\f';
+        }
+        TextPage layout;
+        layout.index = page.index;
+        if (!processPage(worker, page.image, path, text, writer ? &layout : nullptr)) {
+            complete = false;
+            break;
+        }
+        if (writer) {
+            writer->writePage(layout);
+        }
+    }
+    // stops the decoder if a page failed
+    pages.close();
+    if (decoder.joinable()) {
+        decoder.join();
+    }
+    if (unreadPage.load() >= 0) {
+        std::cerr << "Can't read page " << unreadPage.load() + 1 << " of " << path.toStdString() << std::endl;
+        return false;
+    }
+    if (!complete) {
+        return false;
+    }
+
+    if (writer) {
+        if (!writer->end()) {
+            std::cerr << "Can't save text " << file.fileName().toStdString() << std::endl;
+            return false;
+        }
+        return true;
+    }
+    if (!file.open(QIODevice::WriteOnly)) {
+        std::cerr << "Can't save text " << file.fileName().toStdString() << std::endl;
+        return false;
+    }
+    file.write(text.data(), text.size());
+    return true;
+}
+
+/**
+ * Performs OCR on one page
+ *
+ * @param worker owning the engines to be used
+ * @param image of the page
+ * @param path of the file (for error messages)
+ * @param text to which the recognized text is appended
+ * @param layout receiving the word boxes in page coordinates (optional)
+ * @returns false if the detection failed
+ */
+bool BatchProcessor::processPage(Worker &worker, const SharedImage &image, const QString &path, std::string &text,
+    TextPage *layout)
+{
+    cv::Mat frame = image.mat();
+    cv::Mat detectionFrame = frame;
+    PreprocessedFrame preprocessed;     // owns the buffers of the preprocessed frames
+    if (m_options.preprocess.enabled) {
+        TraceSpan span("preprocess");
+        preprocessed = Preprocessor::process(frame, m_options.preprocess);
+        detectionFrame = preprocessed.gray;
+        frame = preprocessed.binary;
+    }
+
+    worker.recognizer.setImage(frame);
+
+    if (m_options.detectAreas) {
+        std::vector<cv::Rect> areas;
+        {
+            TraceSpan span("detect");
+            if (m_batcher) {
+                try {
+                    areas = m_batcher->submit(detectionFrame).get();
+                } catch (const cv::Exception &e) {
+                    std::cerr << "Detection failed for " << path.toStdString() << ": " << e.what() << std::endl;
+                    return false;
+                }
+            } else if (!worker.detector.detect(detectionFrame, areas)) {
+                return false;
+            }
+        }
+        m_boxCount += (long)areas.size();
+        {
+            TraceSpan span("group");
+            areas = TextGrouper::group(areas, (TextGrouper::Mode)m_options.detector.grouping);
+        }
+        m_areaCount += (long)areas.size();
+        TraceSpan span("recognize");
+        if (layout == nullptr) {
+            text += worker.recognizer.recognize(areas);
+        } else {
+            for (size_t i = 0; i < areas.size(); ++i) {
+                TraceSpan areaSpan("recognize_area", (int)i);
+                text += worker.recognizer.recognize(areas[i]);
+                worker.recognizer.readLayout(layout->blocks, (int)i);
+            }
+        }
+    } else {
+        TraceSpan span("recognize");
+        text += worker.recognizer.recognize();
+        if (layout != nullptr) {
+            worker.recognizer.readLayout(layout->blocks);
+        }
+    }
+
+    if (layout != nullptr) {
+        layout->size = cv::Size(image.width(), image.height());
+        const cv::Rect bounds(cv::Point(0, 0), layout->size);
+        mapTextBoxes(layout->blocks, [&preprocessed, &bounds](const cv::Rect &box) {
+            return Preprocessor::mapToSource(box, preprocessed) & bounds;
+        });
+    }
+    return true;
+}
+
+/**
+ * Path of the text file belonging to an image
+ *
+ * @param imagePath of the processed image
+ * @returns full file name with the suffix of the output format appended (scan.png.txt),
+ *          inside the output directory if one is set
+ */
+QString BatchProcessor::outputPath(const QString &imagePath) const
+{
+    QFileInfo info(imagePath);
+    QString name = info.fileName() + "." + m_options.format;
+    if (m_options.outputDir.isEmpty()) {
+        return info.dir().filePath(name);
+    }
+    return QDir(m_options.outputDir).filePath(name);
+}
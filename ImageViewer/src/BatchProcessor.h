@@ -0,0 +1,91 @@
+/**
+ * @file BatchProcessor.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+// system includes
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// local includes
+#include "TextDetector.h"
+#include "TextRecognizer.h"
+#include "DetectionBatcher.h"
+#include "SharedImage.h"
+#include "Preprocessor.h"
+#include "OcrProfile.h"
+#include "TextLayout.h"
+
+/**
+ * Options of a headless batch run
+ */
+struct BatchOptions
+{
+    QStringList inputs;                     // image files, directories or text files listing images
+    QString outputDir;                      // empty: write the text next to each image
+    QString format = "txt";                 // txt (plain text), json or hocr (word boxes and confidences)
+    int threads = 1;                        // number of workers (each with its own engines)
+    bool detectAreas = false;               // detect text areas prior OCR
+    std::string tessdata = TESSDATA_PATH;   // path to the pretrained tessdata
+    std::string language = "eng";
+    DetectorSettings detector;
+    PreprocessSettings preprocess;
+    OcrProfile profile;                     // engine configuration (detector and preprocess are already applied)
+    int detectBatch = 1;                    // >1: detect that many images with one forward pass
+    int batchLatencyMs = 20;                // longest wait for a batch to fill up
+};
+
+/**
+ * Headless OCR of many images using a pool of workers
+ *
+ * BatchProcessor runs the same pipeline as the GUI (optional EAST text
+ * area detection followed by Tesseract OCR) without any window. Every
+ * worker thread owns its own TessBaseAPI and EAST network, so throughput
+ * scales with the number of cores. Alternatively the text area detection
+ * of all workers is collected into batches by a shared DetectionBatcher.
+ * For every image one text file (or JSON/hOCR file with the word boxes,
+ * written page by page) is written, the achieved throughput is reported on
+ * stdout.
+ */
+class BatchProcessor
+{
+public:
+    explicit BatchProcessor(const BatchOptions &options);
+    ~BatchProcessor();
+
+    int run();                              // returns the process exit code
+
+private:
+    static const int PIPELINE_DEPTH = 2;    // decoded pages of a document waiting for recognition
+
+    struct Worker {
+        TextDetector detector;
+        TextRecognizer recognizer;
+        explicit Worker(const DetectorSettings &settings) : detector(settings) {}
+    };
+
+    QStringList collectImages() const;
+    bool createWorkers(int count);
+    bool processImage(Worker &worker, const QString &path);
+    bool processPage(Worker &worker, const SharedImage &image, const QString &path, std::string &text,
+        TextPage *layout = nullptr);
+    QString outputPath(const QString &imagePath) const;
+
+private:
+    BatchOptions m_options;
+    std::vector<std::unique_ptr<Worker>> m_workers;   // pool of engines, one per thread
+    std::unique_ptr<DetectionBatcher> m_batcher;      // shared batched detection (optional)
+    std::atomic<long> m_boxCount;                     // detected boxes of all images
+    std::atomic<long> m_areaCount;                    // recognized areas after grouping
+};
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,84 @@
+/**
+ * @file BoundedQueue.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+// system includes
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+ * Blocking queue with a fixed capacity connecting two pipeline stages
+ *
+ * push() waits while the queue is full, so a fast producer can never run
+ * ahead of the consumer by more than the capacity. Closing the queue wakes
+ * up both sides: pending items can still be popped, new ones are refused.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity > 0 ? capacity : 1), m_closed(false) {}
+
+    /**
+     * Adds an item, waits while the queue is full
+     *
+     * @returns false if the queue was closed
+     */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * Takes the oldest item, waits while the queue is empty
+     *
+     * @returns false if the queue is closed and empty
+     */
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) {
+            return false;
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * No more items are accepted, waiting threads are woken up
+     */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    const size_t m_capacity;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::deque<T> m_items;
+    bool m_closed;
+};
+
+#endif // BOUNDEDQUEUE_H
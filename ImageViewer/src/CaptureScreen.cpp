@@ -1,7 +1,6 @@
 // system includes
 #include <QApplication>
 #include <QGuiApplication>
-#include <QDesktopWidget>
 #include <QMessageBox>
 #include <QRect>
 #include <QScreen>
@@ -9,11 +8,13 @@
 #include <QColor>
 #include <QRegion>
 #include <QShortcut>
+#include <algorithm>
 
 // local includes
 #include "CaptureScreen.h"
 
-CaptureScreen::CaptureScreen(MainWindow *w) : QWidget(nullptr), m_window(w)
+CaptureScreen::CaptureScreen(MainWindow *w, bool watch) : QWidget(nullptr), m_window(w),
+    m_mouseIsPressed(false), m_watch(watch)
 {
     // create a borderless tool window that is on top
     // ignore arrangement, stay topmost window, no title, widget is a tool window
@@ -21,11 +22,12 @@ CaptureScreen::CaptureScreen(MainWindow *w) : QWidget(nullptr), m_window(w)
 
     // delete widget instance if closed
     setAttribute(Qt::WA_DeleteOnClose);
+    // the captured screens cover the whole widget
+    setAttribute(Qt::WA_OpaquePaintEvent);
     // setMouseTracking(true);
 
-    // capture the whole screen in a single image
-    m_screen = captureDesktop();
-    resize(m_screen.size());
+    // capture every screen in its own image
+    captureScreens();
     initShortcuts();
 }
 
@@ -34,54 +36,84 @@ CaptureScreen::~CaptureScreen() {
 
 
 /**
- * Captures all available screens into one image
- *
- * @returns pixmap image of all screens (combined)
+ * Captures every available screen with its own device pixel ratio
+ * The widget is placed over the combined geometry of all screens.
  */
-QPixmap CaptureScreen::captureDesktop() {
+void CaptureScreen::captureScreens() {
 
     // combine all available screens into one geometry
-    QRect geometry;
+    QRect desktop;
+    for (QScreen *const screen : QGuiApplication::screens()) {
+        desktop = desktop.united(screen->geometry());
+    }
+
     for (QScreen *const screen : QGuiApplication::screens()) {
-        geometry = geometry.united(screen->geometry());
+        ScreenGrab grab;
+        grab.geometry = screen->geometry().translated(-desktop.topLeft());
+        grab.ratio = screen->devicePixelRatio();
+        grab.screen = screen;
+        // window 0 grabs the whole screen in physical pixels
+        grab.pixmap = screen->grabWindow(0);
+        grab.pixmap.setDevicePixelRatio(grab.ratio);
+        m_screens.append(grab);
     }
 
-    // create a pixmap image from the combined geometry
-    QPixmap pixmap(QApplication::primaryScreen()->grabWindow(QApplication::desktop()->winId(),
-                                                          geometry.x(),
-                                                          geometry.y(),
-                                                          geometry.width(),
-                                                          geometry.height()
-                                                          )
-            );
-
-    // set the devices pixel ratio
-    pixmap.setDevicePixelRatio(QApplication::desktop()->devicePixelRatio());
-    return pixmap;
+    setGeometry(desktop);
 }
 
 /**
- * Shows the captured screen (called everytime the widget updates)
+ * Shows the captured screens (called everytime the widget updates)
+ * Only the screens and overlay within the updated region are painted.
  *
- * @param any paint event
+ * @param event holding the region to be updated
  */
-void CaptureScreen::paintEvent(QPaintEvent*) {
+void CaptureScreen::paintEvent(QPaintEvent *event) {
 
-    // draw the captured screen
     QPainter painter(this);
-    painter.drawPixmap(0, 0, m_screen);
+    const QRect dirty = event->rect();
+
+    // draw the captured screens
+    for (const ScreenGrab &grab : m_screens) {
+        QRect target = grab.geometry & dirty;
+        if (target.isEmpty()) {
+            continue;
+        }
+        QRectF source(QPointF(target.topLeft() - grab.geometry.topLeft()) * grab.ratio,
+            QSizeF(target.size()) * grab.ratio);
+        painter.drawPixmap(QRectF(target), grab.pixmap, source);
+    }
 
     // draw a translucent gray over selected area (which is constantly updated)
-    QRegion grey(rect());
-    if( m_topRight.x() != m_bottomLeft.x() && m_topRight.y() != m_bottomLeft.y() ) {
+    QRegion grey = event->region();
+    QRect selected = selection();
+    if( selected.width() > 1 && selected.height() > 1 ) {
         painter.setPen( QColor(210, 100, 40, 255) );
-        painter.drawRect( QRect(m_topRight, m_bottomLeft) );
-        grey = grey.subtracted( QRect(m_topRight, m_bottomLeft) );
+        painter.drawRect( selected );
+        grey = grey.subtracted( selected );
     }
     painter.setClipRegion(grey);
     QColor overlayColor(20, 20, 20, 50);
-    painter.fillRect(rect(), overlayColor);
-    painter.setClipRect( rect() );
+    painter.fillRect(dirty, overlayColor);
+}
+
+/**
+ * Selected rectangle, independent of the direction the mouse was moved
+ */
+QRect CaptureScreen::selection() const
+{
+    return QRect(m_topRight, m_bottomLeft).normalized();
+}
+
+/**
+ * Repaints only the area covered by the previous and the current selection
+ *
+ * @param previous selection before the mouse event
+ */
+void CaptureScreen::updateSelection(const QRect &previous)
+{
+    // the frame is drawn on the border of the rectangle
+    QRegion dirty = QRegion(previous.adjusted(-1, -1, 1, 1)) + QRegion(selection().adjusted(-1, -1, 1, 1));
+    update(dirty);
 }
 
 /**
@@ -91,10 +123,11 @@ void CaptureScreen::paintEvent(QPaintEvent*) {
  */
 void CaptureScreen::mousePressEvent(QMouseEvent *event)
 {
+    QRect previous = selection();
     m_mouseIsPressed = true;
     m_topRight = event->pos();
     m_bottomLeft = event->pos();
-    update();
+    updateSelection(previous);
 }
 
 /**
@@ -107,8 +140,9 @@ void CaptureScreen::mouseMoveEvent(QMouseEvent *event)
     // check if mouse is just moved or also pressed
     if( !m_mouseIsPressed ) return;
     // if pressed and moved, update bottomLeft coorinate
+    QRect previous = selection();
     m_bottomLeft = event->pos();
-    update();
+    updateSelection(previous);
 }
 
 /**
@@ -118,9 +152,10 @@ void CaptureScreen::mouseMoveEvent(QMouseEvent *event)
  */
 void CaptureScreen::mouseReleaseEvent(QMouseEvent *event)
 {
+    QRect previous = selection();
     m_mouseIsPressed = false;
     m_bottomLeft = event->pos();
-    update();
+    updateSelection(previous);
 }
 
 /**
@@ -135,14 +170,80 @@ void CaptureScreen::closeScreenCapture()
 
 /**
  * When screen capture is confirmed (return key), show capture as image in GUI
+ * or start watching the selected region
  */
 void CaptureScreen::confirmCapture()
 {
-    QPixmap image = m_screen.copy(QRect(m_topRight, m_bottomLeft));
-    m_window->showImage(image);
+    if (m_watch) {
+        // the region is watched on the screen containing most of it
+        const QRect selected = selection() & rect();
+        const ScreenGrab *best = nullptr;
+        int bestArea = 0;
+        for (const ScreenGrab &grab : m_screens) {
+            QRect part = grab.geometry & selected;
+            if (part.width() * part.height() > bestArea) {
+                bestArea = part.width() * part.height();
+                best = &grab;
+            }
+        }
+        closeScreenCapture();
+        if (best != nullptr) {
+            m_window->watchRegion(best->screen, (best->geometry & selected).translated(-best->geometry.topLeft()));
+        }
+        return;
+    }
+
+    QImage image = cropSelection();
+    if (!image.isNull()) {
+        m_window->showImage(SharedImage(image));
+    }
     closeScreenCapture();
 }
 
+/**
+ * Copies only the selected pixels out of the screen images
+ * A selection spanning several screens is composed at the highest pixel ratio.
+ *
+ * @returns selected part of the screens in physical pixels (null if nothing is selected)
+ */
+QImage CaptureScreen::cropSelection() const
+{
+    const QRect selected = selection() & rect();
+    if (selected.isEmpty()) {
+        return QImage();
+    }
+
+    // most selections lie on a single screen: crop its image
+    for (const ScreenGrab &grab : m_screens) {
+        if (grab.geometry.contains(selected)) {
+            QRect source(QPointF(selected.topLeft() - grab.geometry.topLeft()).toPoint() * grab.ratio,
+                selected.size() * grab.ratio);
+            return grab.pixmap.copy(source).toImage();
+        }
+    }
+
+    qreal ratio = 1.0;
+    for (const ScreenGrab &grab : m_screens) {
+        if (grab.geometry.intersects(selected)) {
+            ratio = std::max(ratio, grab.ratio);
+        }
+    }
+    QImage image(selected.size() * ratio, QImage::Format_RGB32);
+    image.fill(Qt::black);
+    QPainter painter(&image);
+    for (const ScreenGrab &grab : m_screens) {
+        QRect part = grab.geometry & selected;
+        if (part.isEmpty()) {
+            continue;
+        }
+        QRectF target(QPointF(part.topLeft() - selected.topLeft()) * ratio, QSizeF(part.size()) * ratio);
+        QRectF source(QPointF(part.topLeft() - grab.geometry.topLeft()) * grab.ratio,
+            QSizeF(part.size()) * grab.ratio);
+        painter.drawPixmap(target, grab.pixmap, source);
+    }
+    return image;
+}
+
 /**
  * Shortcuts to either close or confirm the screen capture mode
  */
@@ -14,6 +14,9 @@
 #include <QPaintEvent>
 #include <QMouseEvent>
 #include <QPoint>
+#include <QRect>
+#include <QVector>
+#include <QScreen>
 
 // local includes
 #include "MainWindow.h"
@@ -25,15 +28,19 @@
  * the user can not only load images from the drive, but also in form
  * of a screen shot.
  * When capture screen mode is entered, the topmost window is replaced
- * by a combined image of all available screens. He can then use his mouse
+ * by the images of all available screens. He can then use his mouse
  * to select the desired region and either confirm (return) or terminate
- * (escape) the screen capture mode.
+ * (escape) the screen capture mode. In watch mode the selected region is
+ * handed to the main window to be grabbed periodically.
+ * Every screen is grabbed on its own with its device pixel ratio, no
+ * combined image of all screens is created. While selecting, only the area
+ * covered by the old and the new selection is repainted.
  */
 class CaptureScreen : public QWidget {
     Q_OBJECT
 
 public:
-    explicit CaptureScreen(MainWindow *w);
+    explicit CaptureScreen(MainWindow *w, bool watch = false);
     ~CaptureScreen();
 
 protected:
@@ -47,14 +54,25 @@ private slots:
     void confirmCapture();          // cofirm capture and return to GUI
 
 private:
+    struct ScreenGrab {
+        QRect geometry;               // logical geometry in widget coordinates
+        QPixmap pixmap;               // physical pixels of the screen
+        qreal ratio;                  // device pixel ratio of the screen
+        QScreen *screen;
+    };
+
     void initShortcuts();
-    QPixmap captureDesktop();
+    void captureScreens();
+    QRect selection() const;          // normalized selected rectangle
+    void updateSelection(const QRect &previous);
+    QImage cropSelection() const;
 
 private:
     MainWindow *m_window;             // pointer to main window
-    QPixmap m_screen;                 // storing the image of the whole screen
+    QVector<ScreenGrab> m_screens;    // image of every screen
     QPoint m_topRight, m_bottomLeft;  // top right and bottom left point of selected rectangle
     bool m_mouseIsPressed;            // flag to indicate if mouse is pressed or just moving
+    bool m_watch;                     // the selection is watched instead of captured once
 };
 
 
@@ -0,0 +1,133 @@
+// system includes
+#include <algorithm>
+#include <exception>
+
+// local includes
+#include "DetectionBatcher.h"
+
+DetectionBatcher::DetectionBatcher(const DetectorSettings &settings, int maxBatch, int maxLatencyMs) :
+    m_detector(settings), m_maxBatch(std::max(1, maxBatch)),
+    m_maxLatency(std::max(0, maxLatencyMs)), m_stop(false), m_batches(0), m_frames(0)
+{
+}
+
+DetectionBatcher::~DetectionBatcher()
+{
+    stop();
+}
+
+/**
+ * Loads the model and starts the batching thread
+ *
+ * @returns false if the model could not be loaded
+ */
+bool DetectionBatcher::start()
+{
+    if (m_thread.joinable()) {
+        return true;
+    }
+    if (!m_detector.load()) {
+        return false;
+    }
+    m_stop = false;
+    m_thread = std::thread(&DetectionBatcher::run, this);
+    return true;
+}
+
+/**
+ * Detects all pending requests and stops the batching thread
+ */
+void DetectionBatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_changed.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+/**
+ * Queues a frame for detection
+ *
+ * @param frame (8 bit, 3 channels), must stay valid until the result is available
+ * @returns future holding the detected areas in frame coordinates
+ */
+std::future<std::vector<cv::Rect>> DetectionBatcher::submit(const cv::Mat &frame)
+{
+    Request request;
+    request.frame = frame;
+    request.queued = std::chrono::steady_clock::now();
+    std::future<std::vector<cv::Rect>> result = request.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(request));
+    }
+    m_changed.notify_all();
+    return result;
+}
+
+/**
+ * Average number of frames per forward pass so far
+ */
+double DetectionBatcher::averageBatchSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_batches > 0 ? (double)m_frames / m_batches : 0.0;
+}
+
+/**
+ * Batching thread: waits for a full batch or the latency cap, then detects
+ */
+void DetectionBatcher::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_changed.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            break;              // stopped and nothing left to do
+        }
+
+        // wait for more requests until the oldest one reaches the latency cap
+        auto deadline = m_queue.front().queued + m_maxLatency;
+        m_changed.wait_until(lock, deadline, [this]() {
+            return m_stop || (int)m_queue.size() >= m_maxBatch;
+        });
+
+        std::vector<Request> batch;
+        while (!m_queue.empty() && (int)batch.size() < m_maxBatch) {
+            batch.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+        }
+        ++m_batches;
+        m_frames += (long)batch.size();
+        lock.unlock();
+
+        // one forward pass for the whole batch
+        std::vector<cv::Mat> frames;
+        for (const Request &request : batch) {
+            frames.push_back(request.frame);
+        }
+        std::vector<std::vector<cv::Rect>> areas;
+        std::exception_ptr error;
+        try {
+            if (!m_detector.detect(frames, areas)) {
+                // same exception type as the failures of the forward pass, callers catch cv::Exception
+                CV_Error(cv::Error::StsError, "Failed to load " + m_detector.settings().model);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (error) {
+                batch[i].promise.set_exception(error);
+            } else {
+                batch[i].promise.set_value(std::move(areas[i]));
+            }
+        }
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ * @file DetectionBatcher.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef DETECTIONBATCHER_H
+#define DETECTIONBATCHER_H
+
+// system includes
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// local includes
+#include "TextDetector.h"
+
+/**
+ * Collects detection requests of several threads into batches
+ *
+ * DetectionBatcher owns one TextDetector running in its own thread. Frames
+ * submitted by any thread are queued and detected together with a single
+ * forward pass, as soon as either the maximal batch size is reached or the
+ * oldest request waited for the latency cap. The submitted frame must stay
+ * valid until its result is available.
+ */
+class DetectionBatcher
+{
+public:
+    DetectionBatcher(const DetectorSettings &settings, int maxBatch, int maxLatencyMs);
+    ~DetectionBatcher();
+
+    bool start();               // loads the model and starts the batching thread
+    void stop();                // detects the pending requests and stops the thread
+
+    std::future<std::vector<cv::Rect>> submit(const cv::Mat &frame);
+
+    double averageBatchSize() const;
+    const TextDetector &detector() const { return m_detector; }     // only to be read when stopped
+
+private:
+    struct Request {
+        cv::Mat frame;
+        std::promise<std::vector<cv::Rect>> promise;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    void run();
+
+private:
+    TextDetector m_detector;
+    const int m_maxBatch;
+    const std::chrono::milliseconds m_maxLatency;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<Request> m_queue;
+    bool m_stop;
+    std::thread m_thread;
+
+    long m_batches;             // statistics: number of forward passes
+    long m_frames;              // statistics: number of detected frames
+};
+
+#endif // DETECTIONBATCHER_H
@@ -0,0 +1,118 @@
+// system includes
+#include <QFileInfo>
+#include <algorithm>
+#ifdef HAVE_QT_PDF
+#include <QPainter>
+#include <QPdfDocument>
+#endif
+
+// local includes
+#include "DocumentReader.h"
+
+DocumentReader::DocumentReader() : m_pageCount(0)
+{
+}
+
+DocumentReader::~DocumentReader()
+{
+}
+
+/**
+ * Opens a file, only the header is read
+ *
+ * @param path of the image or document
+ * @returns false if the file can not be read
+ */
+bool DocumentReader::open(const QString &path)
+{
+    m_path = path;
+    m_pageCount = 0;
+    m_reader.reset();
+#ifdef HAVE_QT_PDF
+    m_pdf.reset();
+#endif
+
+    if (QFileInfo(path).suffix().compare("pdf", Qt::CaseInsensitive) == 0) {
+#ifdef HAVE_QT_PDF
+        m_pdf.reset(new QPdfDocument());
+        if (m_pdf->load(path) != QPdfDocument::NoError) {
+            return false;
+        }
+        m_pageCount = m_pdf->pageCount();
+        return m_pageCount > 0;
+#else
+        return false;
+#endif
+    }
+
+    m_reader.reset(new QImageReader(path));
+    if (!m_reader->canRead()) {
+        return false;
+    }
+    // formats without pages report 0
+    m_pageCount = std::max(1, m_reader->imageCount());
+    return true;
+}
+
+/**
+ * Decodes one page
+ *
+ * @param index of the page (starting at 0)
+ * @returns page as 8 bit RGB image, null if it could not be decoded
+ */
+SharedImage DocumentReader::page(int index)
+{
+    if (index < 0 || index >= m_pageCount) {
+        return SharedImage();
+    }
+
+#ifdef HAVE_QT_PDF
+    if (m_pdf) {
+        // page size is given in points (1/72 inch)
+        QSizeF points = m_pdf->pageSize(index);
+        QSize pixels = (points * PDF_DPI / 72.0).toSize();
+        QImage rendered = m_pdf->render(index, pixels);
+        if (rendered.isNull()) {
+            return SharedImage();
+        }
+        // the background of a page is transparent, dropping the alpha channel would leave it black
+        QImage page(rendered.size(), QImage::Format_RGB32);
+        page.fill(Qt::white);
+        QPainter painter(&page);
+        painter.drawImage(0, 0, rendered);
+        painter.end();
+        return SharedImage(page);
+    }
+#endif
+
+    if (m_pageCount == 1) {
+        // a single image can only be read once from the same reader
+        m_reader.reset(new QImageReader(m_path));
+    } else if (!m_reader || !m_reader->jumpToImage(index)) {
+        return SharedImage();
+    }
+    return SharedImage(m_reader->read());
+}
+
+/**
+ * Whether a file may contain several pages
+ *
+ * @param path of the file
+ */
+bool DocumentReader::isMultiPage(const QString &path)
+{
+    QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "tif" || suffix == "tiff" || suffix == "pdf";
+}
+
+/**
+ * File name filters of all supported types
+ */
+QStringList DocumentReader::nameFilters()
+{
+    QStringList filters = {"*.png", "*.bmp", "*.jpg", "*.tif", "*.tiff"};
+#ifdef HAVE_QT_PDF
+    filters << "*.pdf";
+#endif
+    return filters;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file DocumentReader.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef DOCUMENTREADER_H
+#define DOCUMENTREADER_H
+
+// system includes
+#include <QImageReader>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+// local includes
+#include "SharedImage.h"
+
+#ifdef HAVE_QT_PDF
+class QPdfDocument;
+#endif
+
+/**
+ * Page by page access to single images and multi-page documents
+ *
+ * Multi-page TIFF files are read with QImageReader, PDF documents are
+ * rendered with QtPdf (if available at build time, HAVE_QT_PDF). Pages are
+ * decoded on demand, only the requested page is held in memory. A reader
+ * is meant to be used by a single thread.
+ */
+class DocumentReader
+{
+public:
+    DocumentReader();
+    ~DocumentReader();
+
+    bool open(const QString &path);
+    int pageCount() const { return m_pageCount; }
+    SharedImage page(int index);                // decodes one page (null on error)
+
+    static bool isMultiPage(const QString &path);   // TIFF or PDF
+    static QStringList nameFilters();               // all readable file types, e.g. "*.png"
+
+private:
+    static const int PDF_DPI = 300;             // resolution of rendered PDF pages
+
+    QString m_path;
+    int m_pageCount;
+    std::unique_ptr<QImageReader> m_reader;
+#ifdef HAVE_QT_PDF
+    std::unique_ptr<QPdfDocument> m_pdf;
+#endif
+};
+
+#endif // DOCUMENTREADER_H
@@ -0,0 +1,155 @@
+// system includes
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EASTDECODER_SSE2
+#endif
+
+// local includes
+#include "EastDecoder.h"
+
+/**
+ * Extract confidences and area from dnn output layers (same result as TextDetector::decode())
+ *
+ * @param scores of each of the detected areas (first layer output)
+ * @param geometry information of the image (second layer output)
+ * @param scoreThresh = confidence threshold
+ * @param detections of possible area candidates
+ * @param confidences for each candidate
+ */
+void EastDecoder::decode(const cv::Mat& scores, const cv::Mat& geometry, float scoreThresh,
+    std::vector<cv::RotatedRect>& detections, std::vector<float>& confidences)
+{
+    CV_Assert(scores.dims == 4); CV_Assert(geometry.dims == 4);
+    CV_Assert(scores.size[0] == 1); CV_Assert(scores.size[1] == 1);
+    CV_Assert(geometry.size[0] == 1);  CV_Assert(geometry.size[1] == 5);
+    CV_Assert(scores.size[2] == geometry.size[2]);
+    CV_Assert(scores.size[3] == geometry.size[3]);
+    CV_Assert(scores.isContinuous() && geometry.isContinuous());
+
+    const int height = scores.size[2];
+    const int width = scores.size[3];
+
+    // pass 1: cells above the threshold
+    compact(scores.ptr<float>(), width * height, scoreThresh);
+
+    // pass 2: geometry of the remaining cells only
+    computeGeometry(geometry, width, height);
+
+    const size_t count = m_scores.size();
+    detections.clear();
+    confidences.clear();
+    detections.reserve(count);
+    confidences.reserve(count);
+    for (size_t k = 0; k < count; ++k) {
+        detections.push_back(cv::RotatedRect(cv::Point2f(m_centerX[k], m_centerY[k]),
+            cv::Size2f(m_width[k], m_height[k]), m_degrees[k]));
+        confidences.push_back(m_scores[k]);
+    }
+}
+
+/**
+ * Collects the indices and scores of all cells which are not below the threshold
+ *
+ * @param scores of the whole score map (row by row)
+ * @param count number of cells
+ * @param scoreThresh = confidence threshold
+ */
+void EastDecoder::compact(const float *scores, int count, float scoreThresh)
+{
+    if ((int)m_cells.size() < count) {
+        m_cells.resize(count);
+    }
+    int n = 0;
+    int i = 0;
+
+#ifdef EASTDECODER_SSE2
+    // 8 cells at once, most of the map is below the threshold and skipped without branching per cell
+    const __m128 thresh = _mm_set1_ps(scoreThresh);
+    for (; i + 8 <= count; i += 8) {
+        int below = _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(scores + i), thresh))
+            | (_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(scores + i + 4), thresh)) << 4);
+        // keep what is not below (like the scalar version, NaN is kept as well)
+        for (int keep = ~below & 0xff, lane = 0; keep != 0; keep >>= 1, ++lane) {
+            if (keep & 1) {
+                m_cells[n++] = i + lane;
+            }
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (!(scores[i] < scoreThresh)) {
+            m_cells[n++] = i;
+        }
+    }
+
+    m_scores.resize(n);
+    for (int k = 0; k < n; ++k) {
+        m_scores[k] = scores[m_cells[k]];
+    }
+}
+
+/**
+ * Computes the rotated boxes of the collected cells
+ * The operations (and their order) are the same as in TextDetector::decode(),
+ * so the results are bitwise identical.
+ *
+ * @param geometry information of the image (second layer output)
+ * @param width of the score map
+ * @param height of the score map
+ */
+void EastDecoder::computeGeometry(const cv::Mat& geometry, int width, int height)
+{
+    const size_t n = m_scores.size();
+    const size_t plane = (size_t)width * height;
+    const float *x0_data = geometry.ptr<float>();
+    const float *x1_data = x0_data + plane;
+    const float *x2_data = x1_data + plane;
+    const float *x3_data = x2_data + plane;
+    const float *anglesData = x3_data + plane;
+
+    m_offsetX.resize(n); m_offsetY.resize(n);
+    m_x0.resize(n); m_x1.resize(n); m_x2.resize(n); m_x3.resize(n); m_angles.resize(n);
+    m_cos.resize(n); m_sin.resize(n);
+    m_centerX.resize(n); m_centerY.resize(n); m_width.resize(n); m_height.resize(n); m_degrees.resize(n);
+
+    // gather the geometry of the remaining cells, the position in the map is resolved here once
+    for (size_t k = 0; k < n; ++k) {
+        const int cell = m_cells[k];
+        // Multiple by 4 because feature maps are 4 time less than input image.
+        m_offsetX[k] = (cell % width) * 4.0f;
+        m_offsetY[k] = (cell / width) * 4.0f;
+        m_x0[k] = x0_data[cell];
+        m_x1[k] = x1_data[cell];
+        m_x2[k] = x2_data[cell];
+        m_x3[k] = x3_data[cell];
+        m_angles[k] = anglesData[cell];
+    }
+
+    // trigonometry of all cells (std::cos/std::sin per element, same values as decode())
+    for (size_t k = 0; k < n; ++k) {
+        m_cos[k] = std::cos(m_angles[k]);
+        m_sin[k] = std::sin(m_angles[k]);
+    }
+
+    // decode the predictions: straight-line float arithmetic over the arrays, no integer division
+    for (size_t k = 0; k < n; ++k) {
+        float offsetX = m_offsetX[k], offsetY = m_offsetY[k];
+        float cosA = m_cos[k];
+        float sinA = m_sin[k];
+        float h = m_x0[k] + m_x2[k];
+        float w = m_x1[k] + m_x3[k];
+
+        float offX = offsetX + cosA * m_x1[k] + sinA * m_x2[k];
+        float offY = offsetY - sinA * m_x1[k] + cosA * m_x2[k];
+        float p1x = -sinA * h + offX, p1y = -cosA * h + offY;
+        float p3x = -cosA * w + offX, p3y = sinA * w + offY;
+
+        m_centerX[k] = (p1x + p3x) * 0.5f;
+        m_centerY[k] = (p1y + p3y) * 0.5f;
+        m_width[k] = w;
+        m_height[k] = h;
+        m_degrees[k] = -m_angles[k] * 180.0f / (float)CV_PI;
+    }
+}
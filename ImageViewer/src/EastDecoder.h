@@ -0,0 +1,47 @@
+/**
+ * @file EastDecoder.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef EASTDECODER_H
+#define EASTDECODER_H
+
+// system includes
+#include <vector>
+
+// local includes
+#include "opencv2/opencv.hpp"
+
+/**
+ * Vectorized decoder of the EAST output layers
+ *
+ * EastDecoder produces exactly the same candidates as TextDetector::decode(),
+ * but in two passes: a SIMD threshold-and-compact pass over the score map
+ * collects the cells above the threshold, then the geometry (including the
+ * trigonometry) is computed only for these cells, pass by pass over arrays. All intermediate
+ * results are kept as structure of arrays in buffers which are reused from
+ * call to call, so a decoder should live as long as its detector.
+ */
+class EastDecoder
+{
+public:
+    void decode(const cv::Mat& scores, const cv::Mat& geometry, float scoreThresh,
+        std::vector<cv::RotatedRect>& detections, std::vector<float>& confidences);
+
+private:
+    void compact(const float *scores, int count, float scoreThresh);
+    void computeGeometry(const cv::Mat& geometry, int width, int height);
+
+private:
+    // candidates as structure of arrays (capacity is kept between calls)
+    std::vector<int> m_cells;               // index of the cell in the score map
+    std::vector<float> m_scores;
+    std::vector<float> m_offsetX, m_offsetY;    // position of the cell in input pixels
+    std::vector<float> m_x0, m_x1, m_x2, m_x3, m_angles;
+    std::vector<float> m_cos, m_sin;
+    std::vector<float> m_centerX, m_centerY, m_width, m_height, m_degrees;
+};
+
+#endif // EASTDECODER_H
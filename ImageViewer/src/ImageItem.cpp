@@ -0,0 +1,271 @@
+// system includes
+#include <QPainter>
+#include <QPen>
+#include <QPixmapCache>
+#include <QStyleOptionGraphicsItem>
+#include <QGraphicsRectItem>
+#include <QGraphicsSimpleTextItem>
+#include <algorithm>
+
+// local includes
+#include "ImageItem.h"
+
+static std::atomic<quint64> s_nextId(1);
+
+ImageItem::ImageItem(const SharedImage &image, QGraphicsItem *parent) : QGraphicsObject(parent),
+    m_image(image), m_id(s_nextId++), m_generation(0), m_stop(false)
+{
+    // the exposed rectangle is needed to paint only the visible part
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+
+    // number of levels: halve until the whole image fits into one tile
+    int levels = 1;
+    for (int size = std::max(image.width(), image.height()); size > TILE_SIZE; size /= 2) {
+        ++levels;
+    }
+    m_levels.resize(levels);
+    startBuilder();
+}
+
+ImageItem::~ImageItem()
+{
+    stopBuilder();
+}
+
+/**
+ * Replaces the image by a new frame of the same size, only the changed parts are painted again
+ *
+ * @param image new frame
+ * @param dirty rectangles which differ from the shown frame
+ * @returns false if the size differs (a new item is needed then)
+ */
+bool ImageItem::updateRegion(const SharedImage &image, const QVector<QRect> &dirty)
+{
+    if (image.width() != m_image.width() || image.height() != m_image.height()) {
+        return false;
+    }
+
+    // a builder still running works on the previous frame
+    stopBuilder();
+    bool complete = true;
+    for (int level = 1; level < m_levels.size(); ++level) {
+        complete = complete && !m_levels[level].isNull();
+    }
+    m_image = image;
+
+    for (const QRect &rect : dirty) {
+        const QRect changed = rect & QRect(0, 0, m_image.width(), m_image.height());
+        if (changed.isEmpty()) {
+            continue;
+        }
+        if (complete) {
+            updateLevels(changed);
+        }
+        // tiles of every level covering the change
+        for (int level = 0; level < m_levels.size(); ++level) {
+            const int tileSize = TILE_SIZE << level;
+            for (int ty = changed.top() / tileSize; ty <= changed.bottom() / tileSize; ++ty) {
+                for (int tx = changed.left() / tileSize; tx <= changed.right() / tileSize; ++tx) {
+                    QPixmapCache::remove(tileKey(level, tx, ty));
+                }
+            }
+        }
+        update(changed);
+    }
+
+    if (!complete) {
+        // levels are built again from the new frame, meanwhile the full resolution is painted
+        for (int level = 1; level < m_levels.size(); ++level) {
+            m_levels[level] = QImage();
+        }
+        startBuilder();
+    }
+    return true;
+}
+
+/**
+ * Shows numbered rectangles around the detected text areas
+ *
+ * @param areas in image coordinates
+ */
+void ImageItem::setAreas(const QVector<QRect> &areas)
+{
+    clearAreas();
+
+    QPen red(QColor(255, 0, 0));
+    red.setCosmetic(true);          // 1 pixel on screen, independent of the zoom
+    for (int i = 0; i < areas.size(); ++i) {
+        QGraphicsRectItem *rect = new QGraphicsRectItem(areas[i], this);
+        rect->setPen(red);
+        QGraphicsSimpleTextItem *index = new QGraphicsSimpleTextItem(QString::number(i), this);
+        index->setBrush(QColor(255, 0, 0));
+        index->setPos(areas[i].x(), areas[i].y() - index->boundingRect().height());
+        m_areaItems << rect << index;
+    }
+}
+
+/**
+ * Removes the rectangles of the detected text areas
+ */
+void ImageItem::clearAreas()
+{
+    qDeleteAll(m_areaItems);
+    m_areaItems.clear();
+}
+
+/**
+ * Size of the image in scene coordinates
+ */
+QRectF ImageItem::boundingRect() const
+{
+    return QRectF(0, 0, m_image.width(), m_image.height());
+}
+
+/**
+ * Paints the visible tiles of the level matching the current zoom
+ */
+void ImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+    QRectF exposed = option->exposedRect.intersected(boundingRect());
+    if (exposed.isEmpty()) {
+        return;
+    }
+    qreal levelOfDetail = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    paintLevel(painter, levelFor(levelOfDetail), exposed);
+}
+
+/**
+ * Starts building the downsampled levels of the current image
+ */
+void ImageItem::startBuilder()
+{
+    if (m_levels.size() > 1) {
+        m_stop = false;
+        m_builder = std::thread(&ImageItem::buildLevels, this, ++m_generation);
+    }
+}
+
+/**
+ * Stops building the levels, those already handed over stay valid
+ */
+void ImageItem::stopBuilder()
+{
+    m_stop = true;
+    if (m_builder.joinable()) {
+        m_builder.join();
+    }
+}
+
+/**
+ * Downsamples the image level by level, each level is handed to the GUI thread when done
+ *
+ * @param generation of the levels, they are dropped if the image was replaced meanwhile
+ */
+void ImageItem::buildLevels(quint64 generation)
+{
+    cv::Mat previous = m_image.mat();
+    for (int level = 1; level < m_levels.size() && !m_stop; ++level) {
+        QImage scaled(std::max(1, previous.cols / 2), std::max(1, previous.rows / 2), QImage::Format_RGB888);
+        cv::Mat target(scaled.height(), scaled.width(), CV_8UC3, scaled.bits(), scaled.bytesPerLine());
+        // an odd last row or column is dropped, so every pixel is the mean of 2x2 pixels
+        const cv::Rect even(0, 0, std::min(previous.cols, target.cols * 2), std::min(previous.rows, target.rows * 2));
+        cv::resize(previous(even), target, target.size(), 0, 0, cv::INTER_AREA);
+        previous = target;
+
+        // the item lives in the GUI thread, the call is dropped if it is deleted meanwhile
+        QMetaObject::invokeMethod(this, [this, level, scaled, generation]() {
+            if (generation == m_generation) {
+                m_levels[level] = scaled;
+                update();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+/**
+ * Downsamples the changed part of the image into the built levels
+ * Every pixel of a level is the mean of 2x2 pixels of the previous one, so
+ * the pixels outside the changed part stay valid.
+ *
+ * @param dirty changed rectangle in image coordinates
+ */
+void ImageItem::updateLevels(const QRect &dirty)
+{
+    cv::Mat previous = m_image.mat();
+    for (int level = 1; level < m_levels.size(); ++level) {
+        QImage &scaled = m_levels[level];
+        // pixels of this level containing a changed pixel
+        const int x0 = (dirty.left() >> level);
+        const int y0 = (dirty.top() >> level);
+        const int x1 = std::min(dirty.right() >> level, scaled.width() - 1);
+        const int y1 = std::min(dirty.bottom() >> level, scaled.height() - 1);
+        if (x1 < x0 || y1 < y0) {
+            break;
+        }
+        cv::Mat target(scaled.height(), scaled.width(), CV_8UC3, scaled.bits(), scaled.bytesPerLine());
+        const cv::Rect area(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+        cv::resize(previous(cv::Rect(area.x * 2, area.y * 2, area.width * 2, area.height * 2)), target(area),
+            area.size(), 0, 0, cv::INTER_AREA);
+        previous = target;
+    }
+}
+
+/**
+ * Key of a tile in the pixmap cache
+ */
+QString ImageItem::tileKey(int level, int x, int y) const
+{
+    return QString("ImageItem/%1/%2/%3/%4").arg(m_id).arg(level).arg(x).arg(y);
+}
+
+/**
+ * Coarsest built level which still has at least one pixel per screen pixel
+ *
+ * @param levelOfDetail scaling of the item on screen
+ * @returns index of the level (0: full resolution)
+ */
+int ImageItem::levelFor(qreal levelOfDetail) const
+{
+    int level = 0;
+    while (level + 1 < m_levels.size() && levelOfDetail <= 1.0 / (2 << level)) {
+        ++level;
+    }
+    while (level > 0 && m_levels[level].isNull()) {
+        --level;
+    }
+    return level;
+}
+
+/**
+ * Paints the tiles of one level intersecting the exposed rectangle
+ *
+ * @param painter of the view
+ * @param level to be painted
+ * @param exposed part of the item (item coordinates)
+ */
+void ImageItem::paintLevel(QPainter *painter, int level, const QRectF &exposed)
+{
+    const QImage &source = level == 0 ? m_image.qimage() : m_levels[level];
+    const qreal fx = (qreal)m_image.width() / source.width();
+    const qreal fy = (qreal)m_image.height() / source.height();
+
+    // exposed rectangle in level coordinates, rounded to whole tiles
+    const int firstX = (int)(exposed.left() / fx) / TILE_SIZE;
+    const int firstY = (int)(exposed.top() / fy) / TILE_SIZE;
+    const int lastX = std::min((int)(exposed.right() / fx), source.width() - 1) / TILE_SIZE;
+    const int lastY = std::min((int)(exposed.bottom() / fy), source.height() - 1) / TILE_SIZE;
+
+    for (int ty = firstY; ty <= lastY; ++ty) {
+        for (int tx = firstX; tx <= lastX; ++tx) {
+            QRect tile = QRect(tx * TILE_SIZE, ty * TILE_SIZE, TILE_SIZE, TILE_SIZE) & source.rect();
+            QString key = tileKey(level, tx, ty);
+            QPixmap pixmap;
+            if (!QPixmapCache::find(key, &pixmap)) {
+                pixmap = QPixmap::fromImage(source.copy(tile));
+                QPixmapCache::insert(key, pixmap);
+            }
+            QRectF target(tile.x() * fx, tile.y() * fy, tile.width() * fx, tile.height() * fy);
+            painter->drawPixmap(target, pixmap, QRectF(pixmap.rect()));
+        }
+    }
+}
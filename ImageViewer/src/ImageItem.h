@@ -0,0 +1,74 @@
+/**
+ * @file ImageItem.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef IMAGEITEM_H
+#define IMAGEITEM_H
+
+// system includes
+#include <QGraphicsObject>
+#include <QImage>
+#include <QVector>
+#include <QRect>
+#include <atomic>
+#include <thread>
+
+// local includes
+#include "SharedImage.h"
+
+/**
+ * Graphics item painting a shared image as tiled level of detail pyramid
+ *
+ * Unlike QGraphicsPixmapItem, no pixmap copy of the whole image is created.
+ * Downsampled levels (each half the size of the previous one) are built in
+ * a background thread, level 0 is the shared buffer itself. Only the tiles
+ * visible in the exposed rectangle are painted, taken from the coarsest
+ * level which still has enough pixels for the current zoom. Tile pixmaps
+ * are kept in QPixmapCache, so its limit bounds their memory. A new frame
+ * of the same size only updates the changed parts of the levels and drops
+ * the tiles covering them.
+ * Detected text areas are shown as child items on top of the image, the
+ * pixels stay untouched.
+ */
+class ImageItem : public QGraphicsObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageItem(const SharedImage &image, QGraphicsItem *parent=nullptr);
+    ~ImageItem();
+
+    const SharedImage &image() const { return m_image; }   // full resolution (used for OCR)
+    bool updateRegion(const SharedImage &image, const QVector<QRect> &dirty);   // same size only
+
+    void setAreas(const QVector<QRect> &areas);    // numbered rectangles on top of the image
+    void clearAreas();
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    void startBuilder();
+    void stopBuilder();
+    void buildLevels(quint64 generation);   // runs in m_builder
+    void updateLevels(const QRect &dirty);
+    QString tileKey(int level, int x, int y) const;
+    int levelFor(qreal levelOfDetail) const;
+    void paintLevel(QPainter *painter, int level, const QRectF &exposed);
+
+private:
+    static const int TILE_SIZE = 512;
+
+    SharedImage m_image;
+    QVector<QImage> m_levels;                       // index 0 unused (shared image), null until built
+    const quint64 m_id;                             // distinguishes the tiles of different items in the cache
+    quint64 m_generation;                           // levels handed over by an older builder are dropped
+    std::atomic<bool> m_stop;
+    std::thread m_builder;                          // builds the downsampled levels
+    QList<QGraphicsItem*> m_areaItems;              // children showing the detected areas
+};
+
+#endif // IMAGEITEM_H
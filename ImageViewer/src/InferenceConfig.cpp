@@ -0,0 +1,132 @@
+// system includes
+#include <QByteArray>
+#include <algorithm>
+
+// local includes
+#include "InferenceConfig.h"
+
+// CPU FP16 is supported by the OpenCV dnn module since 4.8
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 8)
+#define HAVE_DNN_TARGET_CPU_FP16
+#endif
+
+/**
+ * Adds the inference options to a command line parser
+ *
+ * @param parser to add the options to
+ */
+void InferenceConfig::addOptions(QCommandLineParser &parser)
+{
+    parser.addOption({"dnn-backend", "DNN backend of the EAST network: default, opencv or openvino.",
+                      "name", "default"});
+    parser.addOption({"dnn-target", "DNN target of the EAST network: cpu or cpu-fp16.", "name", "cpu"});
+    parser.addOption({"cv-threads", "Number of OpenCV threads (default: OpenCV decides).", "n"});
+    parser.addOption({"warmup", "Run one forward pass right after loading the EAST network."});
+}
+
+/**
+ * Applies the inference options, has to be called before any engine is created
+ *
+ * @param parser holding the parsed command line
+ * @param settings of the detector to be completed (backend, target, warm-up)
+ * @param error message if an option is invalid or not supported by this build
+ * @returns false if an option is invalid
+ */
+bool InferenceConfig::apply(const QCommandLineParser &parser, DetectorSettings &settings, QString &error)
+{
+    if (!parseBackend(parser.value("dnn-backend"), settings.backend)) {
+        error = "Unknown DNN backend " + parser.value("dnn-backend");
+        return false;
+    }
+    if (!parseTarget(parser.value("dnn-target"), settings.target)) {
+        error = "DNN target " + parser.value("dnn-target") + " is unknown or not supported by this OpenCV build";
+        return false;
+    }
+    if (!isAvailable(settings.backend, settings.target)) {
+        error = QString("DNN backend %1 with target %2 is not available in this OpenCV build")
+            .arg(parser.value("dnn-backend")).arg(parser.value("dnn-target"));
+        return false;
+    }
+    settings.warmUp = parser.isSet("warmup");
+
+    // OpenCV thread pool (used by the dnn module)
+    if (parser.isSet("cv-threads")) {
+        cv::setNumThreads(std::max(0, parser.value("cv-threads").toInt()));
+    }
+    return true;
+}
+
+/**
+ * Describes the chosen configuration
+ *
+ * @param settings of the detector
+ * @returns human readable configuration
+ */
+QString InferenceConfig::describe(const DetectorSettings &settings)
+{
+    QString backend;
+    switch (settings.backend) {
+    case cv::dnn::DNN_BACKEND_OPENCV: backend = "opencv"; break;
+    case cv::dnn::DNN_BACKEND_INFERENCE_ENGINE: backend = "openvino"; break;
+    default: backend = "default"; break;
+    }
+    QString target = "cpu";
+#ifdef HAVE_DNN_TARGET_CPU_FP16
+    if (settings.target == cv::dnn::DNN_TARGET_CPU_FP16) {
+        target = "cpu-fp16";
+    }
+#endif
+    // the OpenMP runtime of tesseract reads the limit from the environment at launch only
+    QByteArray ocrThreads = qgetenv("OMP_THREAD_LIMIT");
+
+    return QString("DNN backend %1, target %2, OpenCV threads %3, OCR threads %4")
+        .arg(backend).arg(target).arg(cv::getNumThreads())
+        .arg(ocrThreads.isEmpty() ? QString("default") : QString(ocrThreads));
+}
+
+/**
+ * Maps a backend name to the OpenCV backend
+ */
+bool InferenceConfig::parseBackend(const QString &name, int &backend)
+{
+    if (name == "default") {
+        backend = cv::dnn::DNN_BACKEND_DEFAULT;
+    } else if (name == "opencv") {
+        backend = cv::dnn::DNN_BACKEND_OPENCV;
+    } else if (name == "openvino") {
+        backend = cv::dnn::DNN_BACKEND_INFERENCE_ENGINE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Maps a target name to the OpenCV target (only CPU targets)
+ */
+bool InferenceConfig::parseTarget(const QString &name, int &target)
+{
+    if (name == "cpu") {
+        target = cv::dnn::DNN_TARGET_CPU;
+        return true;
+    }
+#ifdef HAVE_DNN_TARGET_CPU_FP16
+    if (name == "cpu-fp16") {
+        target = cv::dnn::DNN_TARGET_CPU_FP16;
+        return true;
+    }
+#endif
+    return false;
+}
+
+/**
+ * Checks if the OpenCV build supports a backend/target combination
+ */
+bool InferenceConfig::isAvailable(int backend, int target)
+{
+    if (backend == cv::dnn::DNN_BACKEND_DEFAULT) {
+        return true;
+    }
+    std::vector<cv::dnn::Target> targets = cv::dnn::getAvailableTargets((cv::dnn::Backend)backend);
+    return std::find(targets.begin(), targets.end(), (cv::dnn::Target)target) != targets.end();
+}
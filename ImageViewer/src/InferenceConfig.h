@@ -0,0 +1,42 @@
+/**
+ * @file InferenceConfig.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef INFERENCECONFIG_H
+#define INFERENCECONFIG_H
+
+// system includes
+#include <QCommandLineParser>
+#include <QString>
+
+// local includes
+#include "TextDetector.h"
+
+/**
+ * Command line configuration of the inference engines
+ *
+ * InferenceConfig adds the options to choose the DNN backend and target
+ * (device and precision) of the EAST network and the size of the OpenCV
+ * thread pool. The OpenMP threads of Tesseract can't be set from here: the
+ * runtime reads OMP_THREAD_LIMIT once at launch and tesseract fixes the
+ * thread count of its parallel loops, so the limit has to be set in the
+ * environment. The configuration has to be applied before any engine is
+ * created.
+ */
+class InferenceConfig
+{
+public:
+    static void addOptions(QCommandLineParser &parser);
+    static bool apply(const QCommandLineParser &parser, DetectorSettings &settings, QString &error);
+    static QString describe(const DetectorSettings &settings);
+
+private:
+    static bool parseBackend(const QString &name, int &backend);
+    static bool parseTarget(const QString &name, int &target);
+    static bool isAvailable(int backend, int target);
+};
+
+#endif // INFERENCECONFIG_H
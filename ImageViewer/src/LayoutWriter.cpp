@@ -0,0 +1,198 @@
+// system includes
+#include <QFileInfo>
+
+// local includes
+#include "LayoutWriter.h"
+
+/**
+ * Creates a writer on an open device
+ *
+ * @param device opened for writing, not owned
+ * @param format of the output
+ */
+LayoutWriter::LayoutWriter(QIODevice *device, Format format) : m_device(device), m_format(format),
+    m_pages(0), m_failed(false)
+{
+}
+
+/**
+ * Output format belonging to a file name
+ *
+ * @param path of the output file
+ * @param format set if the suffix is known
+ * @returns false for other suffixes
+ */
+bool LayoutWriter::formatOf(const QString &path, Format &format)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "json") {
+        format = Json;
+    } else if (suffix == "hocr" || suffix == "html") {
+        format = Hocr;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Writes the document header
+ *
+ * @param source path of the image or document
+ */
+void LayoutWriter::begin(const QString &source)
+{
+    m_pages = 0;
+    if (m_format == Json) {
+        write("{\"source\": " + jsonString(source.toStdString()) + ", \"pages\": [");
+        return;
+    }
+    write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+          "<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.0 Transitional//EN\"\n"
+          "    \"http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd\">\n"
+          "<html xmlns=\"http://www.w3.org/1999/xhtml\" xml:lang=\"en\" lang=\"en\">\n"
+          "<head>\n"
+          "  <title>" + xmlEscaped(QFileInfo(source).fileName().toStdString()) + "</title>\n"
+          "  <meta http-equiv=\"Content-Type\" content=\"text/html;charset=utf-8\"/>\n"
+          "  <meta name=\"ocr-system\" content=\"ImageViewer (EAST, Tesseract)\"/>\n"
+          "  <meta name=\"ocr-capabilities\" content=\"ocr_page ocr_carea ocr_line ocrx_word\"/>\n"
+          "</head>\n"
+          "<body>\n");
+    m_sourceName = xmlEscaped(source.toStdString());
+}
+
+/**
+ * Writes one page, the page can be released afterwards
+ *
+ * @param page word level result
+ */
+void LayoutWriter::writePage(const TextPage &page)
+{
+    const QByteArray pageNumber = QByteArray::number(page.index + 1);
+    if (m_format == Json) {
+        write(QByteArray(m_pages > 0 ? "," : "") + "\n  {\"page\": " + pageNumber
+            + ", \"width\": " + QByteArray::number(page.size.width)
+            + ", \"height\": " + QByteArray::number(page.size.height) + ", \"blocks\": [");
+        for (size_t b = 0; b < page.blocks.size(); ++b) {
+            const TextBlock &block = page.blocks[b];
+            write(QByteArray(b > 0 ? "," : "") + "\n    {\"area\": " + QByteArray::number(block.area)
+                + ", \"box\": " + jsonBox(block.box)
+                + ", \"confidence\": " + QByteArray::number(block.confidence, 'f', 1) + ", \"lines\": [");
+            for (size_t l = 0; l < block.lines.size(); ++l) {
+                const TextLine &line = block.lines[l];
+                QByteArray data = QByteArray(l > 0 ? "," : "") + "\n      {\"box\": " + jsonBox(line.box)
+                    + ", \"confidence\": " + QByteArray::number(line.confidence, 'f', 1) + ", \"words\": [";
+                for (size_t w = 0; w < line.words.size(); ++w) {
+                    const TextWord &word = line.words[w];
+                    data += QByteArray(w > 0 ? "," : "") + "\n        {\"text\": " + jsonString(word.text)
+                        + ", \"box\": " + jsonBox(word.box)
+                        + ", \"confidence\": " + QByteArray::number(word.confidence, 'f', 1) + "}";
+                }
+                write(data + "]}");
+            }
+            write("]}");
+        }
+        write("]}");
+    } else {
+        write("<div class='ocr_page' id='page_" + pageNumber + "' title='image \"" + m_sourceName
+            + "\"; bbox 0 0 " + QByteArray::number(page.size.width) + " " + QByteArray::number(page.size.height)
+            + "; ppageno " + QByteArray::number(page.index) + "'>\n");
+        int lineId = 0;
+        int wordId = 0;
+        for (size_t b = 0; b < page.blocks.size(); ++b) {
+            const TextBlock &block = page.blocks[b];
+            write(" <div class='ocr_carea' id='block_" + pageNumber + "_" + QByteArray::number((int)b + 1)
+                + "' title='" + hocrBox(block.box) + "'>\n");
+            for (const TextLine &line : block.lines) {
+                QByteArray data = "  <span class='ocr_line' id='line_" + pageNumber + "_"
+                    + QByteArray::number(++lineId) + "' title='" + hocrBox(line.box) + "'>";
+                for (const TextWord &word : line.words) {
+                    data += "<span class='ocrx_word' id='word_" + pageNumber + "_" + QByteArray::number(++wordId)
+                        + "' title='" + hocrBox(word.box) + "; x_wconf " + QByteArray::number(qRound(word.confidence))
+                        + "'>" + xmlEscaped(word.text) + "</span> ";
+                }
+                write(data + "</span>\n");
+            }
+            write(" </div>\n");
+        }
+        write("</div>\n");
+    }
+    ++m_pages;
+}
+
+/**
+ * Closes the document
+ *
+ * @returns false if any part could not be written
+ */
+bool LayoutWriter::end()
+{
+    write(m_format == Json ? "\n]}\n" : "</body>\n</html>\n");
+    return !m_failed;
+}
+
+/**
+ * Writes to the device, a failure is remembered for end()
+ */
+void LayoutWriter::write(const QByteArray &data)
+{
+    if (!m_failed && m_device->write(data) != data.size()) {
+        m_failed = true;
+    }
+}
+
+/**
+ * Box as JSON array [x, y, width, height]
+ */
+QByteArray LayoutWriter::jsonBox(const cv::Rect &box)
+{
+    return "[" + QByteArray::number(box.x) + ", " + QByteArray::number(box.y) + ", "
+        + QByteArray::number(box.width) + ", " + QByteArray::number(box.height) + "]";
+}
+
+/**
+ * Quoted JSON string, control characters are escaped
+ */
+QByteArray LayoutWriter::jsonString(const std::string &text)
+{
+    QByteArray quoted = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += (char)c;
+        } else if (c < 0x20) {
+            quoted += QByteArray("\\u00") + QByteArray::number(c, 16).rightJustified(2, '0');
+        } else {
+            quoted += (char)c;
+        }
+    }
+    return quoted + "\"";
+}
+
+/**
+ * Box as hOCR property "bbox x0 y0 x1 y1"
+ */
+QByteArray LayoutWriter::hocrBox(const cv::Rect &box)
+{
+    return "bbox " + QByteArray::number(box.x) + " " + QByteArray::number(box.y) + " "
+        + QByteArray::number(box.br().x) + " " + QByteArray::number(box.br().y);
+}
+
+/**
+ * Text with the XML special characters escaped
+ */
+QByteArray LayoutWriter::xmlEscaped(const std::string &text)
+{
+    QByteArray escaped;
+    for (char c : text) {
+        switch (c) {
+        case '<': escaped += "&lt;"; break;
+        case '>': escaped += "&gt;"; break;
+        case '&': escaped += "&amp;"; break;
+        case '"': escaped += "&quot;"; break;
+        case '\'': escaped += "&#39;"; break;
+        default: escaped += c;
+        }
+    }
+    return escaped;
+}
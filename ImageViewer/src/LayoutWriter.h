@@ -0,0 +1,60 @@
+/**
+ * @file LayoutWriter.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef LAYOUTWRITER_H
+#define LAYOUTWRITER_H
+
+// system includes
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+// local includes
+#include "TextLayout.h"
+
+/**
+ * Streaming writer of the word level results as JSON or hOCR
+ *
+ * The document is written page by page as the pages are passed in, only
+ * the current page is held in memory, so the output of a long document
+ * never exists as a whole. The JSON lists the blocks, lines and words of
+ * every page with box ([x, y, width, height]) and confidence; hOCR uses the
+ * classes ocr_page, ocr_carea, ocr_line and ocrx_word with bbox and
+ * x_wconf, as written by Tesseract itself.
+ */
+class LayoutWriter
+{
+public:
+    enum Format {
+        Json,
+        Hocr
+    };
+
+    LayoutWriter(QIODevice *device, Format format);
+
+    static bool formatOf(const QString &path, Format &format);     // by the suffix (.json, .hocr, .html)
+
+    void begin(const QString &source);          // source image or document
+    void writePage(const TextPage &page);
+    bool end();                                 // returns false if the device could not be written
+
+private:
+    void write(const QByteArray &data);
+    static QByteArray jsonBox(const cv::Rect &box);
+    static QByteArray jsonString(const std::string &text);
+    static QByteArray hocrBox(const cv::Rect &box);
+    static QByteArray xmlEscaped(const std::string &text);
+
+private:
+    QIODevice *m_device;
+    const Format m_format;
+    QByteArray m_sourceName;    // XML escaped path of the source (hOCR)
+    int m_pages;                // pages written so far
+    bool m_failed;              // a write failed
+};
+
+#endif // LAYOUTWRITER_H
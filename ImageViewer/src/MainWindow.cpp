@@ -5,23 +5,62 @@
 #include <QKeyEvent>
 #include <QSplitter>
 #include <QDebug>
+#include <QTextCursor>
+#include <QPixmapCache>
+#include <algorithm>
 
 // local includes
 #include "MainWindow.h"
 #include "CaptureScreen.h"
+#include "LayoutWriter.h"
+#include "Tracer.h"
 
-MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), m_currentImage(nullptr), m_tesseractAPI(nullptr)
+MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), m_currentImage(nullptr),
+    m_currentPageCount(0), m_ocrWorker(nullptr), m_ocrRunning(false), m_captureForWatch(false), m_watchBusy(false)
 {
+    // the watch mode grabs in the gui thread, only changed parts are sent to the worker
+    m_watcher = new RegionWatcher(this);
+
     initUI();
+
+    // the ocr engines live in their own thread, the worker is deleted together with the thread
+    qRegisterMetaType<OcrOptions>("OcrOptions");
+    qRegisterMetaType<SharedImage>("SharedImage");
+    qRegisterMetaType<QVector<QRect>>("QVector<QRect>");
+    qRegisterMetaType<TextPage>("TextPage");
+    m_ocrWorker = new OcrWorker();
+    m_ocrWorker->moveToThread(&m_ocrThread);
+    connect(&m_ocrThread, SIGNAL(finished()), m_ocrWorker, SLOT(deleteLater()));
+    connect(this, SIGNAL(ocrRequested(SharedImage,OcrOptions)), m_ocrWorker, SLOT(process(SharedImage,OcrOptions)));
+    connect(m_ocrWorker, SIGNAL(stageChanged(QString,int)), this, SLOT(showOcrStage(QString,int)));
+    connect(m_ocrWorker, SIGNAL(areasDetected(QVector<QRect>)), this, SLOT(showDetectedAreas(QVector<QRect>)));
+    connect(m_ocrWorker, SIGNAL(textRecognized(int,QString)), this, SLOT(appendText(int,QString)));
+    connect(m_ocrWorker, SIGNAL(layoutRecognized(TextPage)), this, SLOT(collectLayout(TextPage)));
+    connect(m_ocrWorker, SIGNAL(finished(bool,QString)), this, SLOT(ocrFinished(bool,QString)));
+    connect(m_ocrWorker, SIGNAL(failed(QString)), this, SLOT(ocrFailed(QString)));
+    connect(m_ocrWorker, SIGNAL(cacheStatsChanged(int,int)), this, SLOT(showCacheStats(int,int)));
+    connect(m_ocrWorker, SIGNAL(stagesTimed(QString)), this, SLOT(showStageTimes(QString)));
+    connect(this, SIGNAL(documentRequested(QString,OcrOptions)), m_ocrWorker, SLOT(processDocument(QString,OcrOptions)));
+    connect(this, SIGNAL(regionsRequested(SharedImage,QVector<QRect>,OcrOptions)),
+        m_ocrWorker, SLOT(processRegions(SharedImage,QVector<QRect>,OcrOptions)));
+    connect(m_ocrWorker, SIGNAL(regionsRecognized(QVector<QRect>,QVector<QRect>,QStringList)),
+        this, SLOT(watchedRegionRecognized(QVector<QRect>,QVector<QRect>,QStringList)));
+    connect(m_watcher, SIGNAL(regionChanged(SharedImage,QVector<QRect>)),
+        this, SLOT(watchedRegionChanged(SharedImage,QVector<QRect>)));
+    connect(this, SIGNAL(preloadRequested(OcrOptions)), m_ocrWorker, SLOT(preload(OcrOptions)));
+    connect(m_ocrWorker, SIGNAL(preloaded(QString)), this, SLOT(enginesPreloaded(QString)));
+    m_ocrThread.start();
+
+    // the engines are loaded while the window appears (after the settings of the command line are set)
+    QTimer::singleShot(0, this, SLOT(preloadEngines()));
 }
 
 MainWindow::~MainWindow()
 {
-    // Destroy object to release memory
-    if(m_tesseractAPI != nullptr) {
-        m_tesseractAPI->End();
-        delete m_tesseractAPI;
-    }
+    // stop a running job and wait for the worker thread
+    m_ocrWorker->cancel();
+    m_ocrThread.quit();
+    m_ocrThread.wait();
 }
 
 /**
@@ -44,11 +83,21 @@ void MainWindow::initUI()
 
     m_imageScene = new QGraphicsScene(this);
     m_imageView = new QGraphicsView(m_imageScene);
+    m_imageView->setDragMode(QGraphicsView::ScrollHandDrag);
+    m_imageView->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
     splitter->addWidget(m_imageView);     // left side is image view
 
-    m_editor = new QTextEdit(this);
+    // room for the visible tiles of large images (in KB)
+    QPixmapCache::setCacheLimit(std::max(QPixmapCache::cacheLimit(), 128 * 1024));
+
+    m_editor = new QPlainTextEdit(this);
     splitter->addWidget(m_editor);        // right side is editor view
 
+    // streamed text is appended at most every 50 ms
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(50);
+    connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flushText()));
+
     // initial sizes of the two views
     QList<int> sizes = {400, 400};
     splitter->setSizes(sizes);
@@ -60,6 +109,11 @@ void MainWindow::initUI()
     m_mainStatusLabel = new QLabel(m_mainStatusBar);
     m_mainStatusBar->addPermanentWidget(m_mainStatusLabel);
     m_mainStatusLabel->setText("C++ II HS2019 - OCR GUI - Simon Schweizer");
+    m_cacheStatusLabel = new QLabel(m_mainStatusBar);
+    m_mainStatusBar->addPermanentWidget(m_cacheStatusLabel);
+    m_traceStatusLabel = new QLabel(m_mainStatusBar);
+    m_mainStatusBar->addWidget(m_traceStatusLabel, 1);
+    Tracer::instance().setThreadName("gui");
 
     // create actions (menus, toolbars etc.)
     createActions();
@@ -77,6 +131,10 @@ void MainWindow::createActions()
     m_fileMenu->addAction(m_saveImageAsAction);
     m_saveTextAsAction = new QAction("Save &Text as", this);
     m_fileMenu->addAction(m_saveTextAsAction);
+    m_saveLayoutAsAction = new QAction("Save &Layout as", this);
+    m_fileMenu->addAction(m_saveLayoutAsAction);
+    m_saveTraceAsAction = new QAction("Save T&race as", this);
+    m_fileMenu->addAction(m_saveTraceAsAction);
     m_exitAction = new QAction("E&xit", this);
     m_fileMenu->addAction(m_exitAction);
 
@@ -88,14 +146,69 @@ void MainWindow::createActions()
     m_fileToolBar->addAction(m_ocrAction);
     m_detectAreaCheckBox = new QCheckBox("Detect text areas", this);
     m_fileToolBar->addWidget(m_detectAreaCheckBox);
+    m_profileComboBox = new QComboBox(this);
+    for (const OcrProfile &profile : OcrProfile::all()) {
+        QString name = QString::fromStdString(profile.name);
+        m_profileComboBox->addItem(name.left(1).toUpper() + name.mid(1), name);
+    }
+    m_fileToolBar->addWidget(m_profileComboBox);
+    m_preprocessCheckBox = new QCheckBox("Preprocess", this);
+    m_preprocessCheckBox->setToolTip("Grayscale, deskew and binarize the image before detection and OCR");
+    m_fileToolBar->addWidget(m_preprocessCheckBox);
+    m_tileComboBox = new QComboBox(this);
+    m_tileComboBox->addItem("Whole frame", 0);
+    m_tileComboBox->addItem("Tiles 320", 320);
+    m_tileComboBox->addItem("Tiles 640", 640);
+    m_tileComboBox->addItem("Tiles 960", 960);
+    m_fileToolBar->addWidget(m_tileComboBox);
+    m_scaleSpinBox = new QDoubleSpinBox(this);
+    m_scaleSpinBox->setPrefix("Scale ");
+    m_scaleSpinBox->setRange(0.25, 4.0);
+    m_scaleSpinBox->setSingleStep(0.25);
+    m_scaleSpinBox->setValue(1.0);
+    m_fileToolBar->addWidget(m_scaleSpinBox);
+    m_groupComboBox = new QComboBox(this);
+    m_groupComboBox->addItem("Words", TextGrouper::Words);
+    m_groupComboBox->addItem("Lines", TextGrouper::Lines);
+    m_groupComboBox->addItem("Paragraphs", TextGrouper::Paragraphs);
+    m_groupComboBox->setCurrentIndex(m_groupComboBox->findData(TextGrouper::Lines));
+    m_fileToolBar->addWidget(m_groupComboBox);
+    m_profileComboBox->setCurrentIndex(m_profileComboBox->findData("balanced"));
+    m_cancelAction = new QAction("Cancel OCR", this);
+    m_cancelAction->setEnabled(false);
+    m_fileToolBar->addAction(m_cancelAction);
+    m_watchAction = new QAction("Watch region", this);
+    m_fileToolBar->addAction(m_watchAction);
+    m_watchIntervalSpinBox = new QSpinBox(this);
+    m_watchIntervalSpinBox->setPrefix("every ");
+    m_watchIntervalSpinBox->setSuffix(" ms");
+    m_watchIntervalSpinBox->setRange(100, 60000);
+    m_watchIntervalSpinBox->setSingleStep(100);
+    m_watchIntervalSpinBox->setValue(1000);
+    m_fileToolBar->addWidget(m_watchIntervalSpinBox);
+    m_zoomInAction = new QAction("Zoom in", this);
+    m_fileToolBar->addAction(m_zoomInAction);
+    m_zoomOutAction = new QAction("Zoom out", this);
+    m_fileToolBar->addAction(m_zoomOutAction);
+    m_fitAction = new QAction("Fit", this);
+    m_fileToolBar->addAction(m_fitAction);
 
     // connect signals and slots
     connect(m_exitAction, SIGNAL(triggered(bool)), QApplication::instance(), SLOT(quit()));
     connect(m_openAction, SIGNAL(triggered(bool)), this, SLOT(openImage()));
     connect(m_saveImageAsAction, SIGNAL(triggered(bool)), this, SLOT(saveImageAs()));
     connect(m_saveTextAsAction, SIGNAL(triggered(bool)), this, SLOT(saveTextAs()));
+    connect(m_saveLayoutAsAction, SIGNAL(triggered(bool)), this, SLOT(saveLayoutAs()));
+    connect(m_saveTraceAsAction, SIGNAL(triggered(bool)), this, SLOT(saveTraceAs()));
     connect(m_ocrAction, SIGNAL(triggered(bool)), this, SLOT(extractText()));
     connect(m_captureAction, SIGNAL(triggered(bool)), this, SLOT(captureScreen()));
+    connect(m_cancelAction, SIGNAL(triggered(bool)), this, SLOT(cancelOcr()));
+    connect(m_watchAction, SIGNAL(triggered(bool)), this, SLOT(watchScreen()));
+    connect(m_watchIntervalSpinBox, SIGNAL(valueChanged(int)), m_watcher, SLOT(setInterval(int)));
+    connect(m_zoomInAction, SIGNAL(triggered(bool)), this, SLOT(zoomIn()));
+    connect(m_zoomOutAction, SIGNAL(triggered(bool)), this, SLOT(zoomOut()));
+    connect(m_fitAction, SIGNAL(triggered(bool)), this, SLOT(fitImage()));
+    connect(m_profileComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(applyProfile(int)));
 
     // set up some shortcuts
     setupShortcuts();
@@ -109,7 +222,7 @@ void MainWindow::openImage()
     QFileDialog dialog(this);
     dialog.setWindowTitle("Open Image");
     dialog.setFileMode(QFileDialog::ExistingFile);
-    dialog.setNameFilter(tr("Images (*.png *.bmp *.jpg)"));
+    dialog.setNameFilter(tr("Images and documents (%1)").arg(DocumentReader::nameFilters().join(" ")));
     QStringList filePaths;
     if (dialog.exec()) {
         filePaths = dialog.selectedFiles();
@@ -124,44 +237,42 @@ void MainWindow::openImage()
  */
 void MainWindow::showImage(QString path)
 {
-    QPixmap image(path);
+    // of documents only the first page is decoded and shown
+    DocumentReader reader;
+    if (!reader.open(path)) {
+        QMessageBox::information(this, "Error", "Can't read " + path);
+        return;
+    }
+    SharedImage image = reader.page(0);
     showImage(image);
     m_currentImagePath = path;
+    m_currentPageCount = reader.pageCount();
     QString status = QString("%1, %2x%3, %4 Bytes").arg(path).arg(image.width())
         .arg(image.height()).arg(QFile(path).size());
+    if (m_currentPageCount > 1) {
+        status += QString(", %1 pages").arg(m_currentPageCount);
+    }
     m_mainStatusLabel->setText(status);
 }
 
 /**
- * Show image with detected frames
- *
- * @param mat image with frames
- */
-void MainWindow::showImage(cv::Mat mat)
-{
-    QImage image(mat.data, mat.cols, mat.rows, mat.step, QImage::Format_RGB888);
-
-    QPixmap pixmap = QPixmap::fromImage(image);
-    m_imageScene->clear();
-    m_imageView->resetMatrix();
-    m_currentImage = m_imageScene->addPixmap(pixmap);
-    m_imageScene->update();
-    m_imageView->setSceneRect(pixmap.rect());
-}
-
-/**
- * show an image captured from the screen (QPixmap overloading)
+ * Show a shared image, the view paints straight from the shared buffer
  *
  * @param image to be shown
+ * @param resetView whether the zoom is reset
  */
-void MainWindow::showImage(QPixmap image)
+void MainWindow::showImage(const SharedImage &image, bool resetView)
 {
+    m_currentPageCount = 1;
     m_imageScene->clear();
-    m_imageView->resetMatrix();
-    m_currentImage = m_imageScene->addPixmap(image);
+    if (resetView) {
+        m_imageView->resetMatrix();
+    }
+    m_currentImage = new ImageItem(image);
+    m_imageScene->addItem(m_currentImage);
     m_imageScene->update();
-    m_imageView->setSceneRect(image.rect());
- }
+    m_imageView->setSceneRect(m_currentImage->boundingRect());
+}
 
 /**
  * Save imageview content as image
@@ -184,7 +295,7 @@ void MainWindow::saveImageAs()
     if (dialog.exec()) {
         fileNames = dialog.selectedFiles();
         if(QRegExp(".+\\.(png|bmp|jpg)").exactMatch(fileNames.at(0))) {
-            m_currentImage->pixmap().save(fileNames.at(0));
+            m_currentImage->image().qimage().save(fileNames.at(0));
         } else {
             QMessageBox::information(this, "Error", "Save error: bad format or filename.");
         }
@@ -219,6 +330,57 @@ void MainWindow::saveTextAs()
     }
 }
 
+/**
+ * Save the words, lines and blocks of the last OCR job with boxes and confidences
+ * The format follows the suffix: JSON (.json) or hOCR (.hocr, .html).
+ */
+void MainWindow::saveLayoutAs()
+{
+    if (m_layoutPages.empty()) {
+        QMessageBox::information(this, "Information",
+            "There are no word boxes for the current text, please run OCR (cached results only keep the text).");
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Layout as..", "layout.json",
+        tr("JSON (*.json);;hOCR (*.hocr *.html)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    LayoutWriter::Format format;
+    if (!LayoutWriter::formatOf(fileName, format)) {
+        QMessageBox::information(this, "Error", "Save error: format or filename not ok.");
+        return;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        QMessageBox::information(this, "Error", "Can't save layout.");
+        return;
+    }
+    LayoutWriter writer(&file, format);
+    writer.begin(m_currentImagePath);
+    for (const TextPage &page : m_layoutPages) {
+        writer.writePage(page);
+    }
+    if (!writer.end()) {
+        QMessageBox::information(this, "Error", "Can't save layout.");
+    }
+}
+
+/**
+ * Save the timing spans of all OCR jobs as Chrome trace (chrome://tracing, ui.perfetto.dev)
+ */
+void MainWindow::saveTraceAs()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Trace as..", "ocr-trace.json",
+        tr("Chrome trace (*.json)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!Tracer::instance().writeChromeTrace(fileName.toStdString())) {
+        QMessageBox::information(this, "Error", "Can't save trace.");
+    }
+}
+
 /**
  * Setting up two shortcuts for convenience
  */
@@ -233,10 +395,85 @@ void MainWindow::setupShortcuts()
     shortcuts.clear();
     shortcuts << (Qt::CTRL + Qt::Key_Q);
     m_exitAction->setShortcuts(shortcuts);
+
+    // ESCAPE to cancel a running ocr job
+    shortcuts.clear();
+    shortcuts << Qt::Key_Escape;
+    m_cancelAction->setShortcuts(shortcuts);
+
+    // CNTRL + '+' / '-' / '0' to zoom
+    m_zoomInAction->setShortcuts(QKeySequence::ZoomIn);
+    m_zoomOutAction->setShortcuts(QKeySequence::ZoomOut);
+    shortcuts.clear();
+    shortcuts << (Qt::CTRL + Qt::Key_0);
+    m_fitAction->setShortcuts(shortcuts);
+}
+
+/**
+ * Zoom into the image, the view paints a finer level of the image
+ */
+void MainWindow::zoomIn()
+{
+    m_imageView->scale(1.25, 1.25);
+}
+
+/**
+ * Zoom out of the image, the view paints a coarser level of the image
+ */
+void MainWindow::zoomOut()
+{
+    m_imageView->scale(0.8, 0.8);
+}
+
+/**
+ * Scale the image to fit into the view
+ */
+void MainWindow::fitImage()
+{
+    if (m_currentImage != nullptr) {
+        m_imageView->fitInView(m_currentImage, Qt::KeepAspectRatio);
+    }
+}
+
+/**
+ * Presets the toolbar with the grouping and preprocessing of a profile
+ * Both can still be changed, the engine settings of the profile are kept.
+ *
+ * @param index of the profile in the combo box
+ */
+void MainWindow::applyProfile(int index)
+{
+    OcrProfile profile;
+    if (!OcrProfile::find(m_profileComboBox->itemData(index).toString().toStdString(), profile)) {
+        return;
+    }
+    m_groupComboBox->setCurrentIndex(m_groupComboBox->findData(profile.grouping));
+    m_preprocessCheckBox->setChecked(profile.preprocess);
+}
+
+/**
+ * Loads the engines of the selected profile in the background
+ * A job requested meanwhile waits in the worker thread until they are ready.
+ */
+void MainWindow::preloadEngines()
+{
+    m_mainStatusBar->showMessage("Loading models...");
+    emit preloadRequested(ocrOptions());
+}
+
+/**
+ * Reports the preloading of the engines
+ *
+ * @param summary of the preloading (or why it failed)
+ */
+void MainWindow::enginesPreloaded(QString summary)
+{
+    m_mainStatusBar->showMessage(summary, 5000);
 }
 
 /**
  * Extract text from image either using Tesseract OCR
+ * The job runs in the background, results are streamed back through signals.
  */
 void MainWindow::extractText()
 {
@@ -246,190 +483,181 @@ void MainWindow::extractText()
         return;
     }
 
-    // if there is an image, create Tesseract instance
-    char *old_ctype = strdup(setlocale(LC_ALL, NULL));
-    setlocale(LC_ALL, "C");
-
-    // only initialize tesseract api once
-    if (m_tesseractAPI == nullptr) {
-        m_tesseractAPI = new tesseract::TessBaseAPI();
-        // Initialize tesseract-ocr with pretrained eng data
-        if (m_tesseractAPI->Init("/home/simon/programs/tesseract/share/tessdata", "eng")) {
-            QMessageBox::information(this, "Error", "Failed to initialize tesseract.");
-            return;
-        }
+    // only one job at a time
+    if (m_ocrRunning) {
+        return;
     }
 
-    // convert image into pixmap (convertion to 8Biit RGB allows any input format)
-    QPixmap pixmap = m_currentImage->pixmap();
-    QImage image = pixmap.toImage();
-    image = image.convertToFormat(QImage::Format_RGB888);
-
-    // pass image to tess api
-    m_tesseractAPI->SetImage(image.bits(), image.width(), image.height(),
-        3, image.bytesPerLine());
-
-    // get the text from the image
-    if (m_detectAreaCheckBox->checkState() == Qt::Checked) {
-        std::vector<cv::Rect> areas;
-        cv::Mat newImage = detectTextAreas(image, areas);   // detect areas if OCR checkbox activated
-        showImage(newImage);
-        m_editor->setPlainText("");
-        for(cv::Rect &rect : areas) {
-            m_tesseractAPI->SetRectangle(rect.x, rect.y, rect.width, rect.height);
-            char *outText = m_tesseractAPI->GetUTF8Text();
-            m_editor->setPlainText(m_editor->toPlainText() + outText);
-            delete [] outText;
-        }
+    OcrOptions options = ocrOptions();
+
+    // the job works on the shared buffer of the shown image (no copy)
+    m_currentImage->clearAreas();
+    m_flushTimer.stop();
+    m_pendingText.clear();
+    m_editor->clear();
+    m_layoutPages.clear();
+    setOcrRunning(true);
+    TraceSpan span("extract_text");
+    m_ocrWorker->jobQueued();
+    if (m_currentPageCount > 1) {
+        // all pages are decoded again by the worker, one after the other
+        emit documentRequested(m_currentImagePath, options);
     } else {
-        char *outText = m_tesseractAPI->GetUTF8Text();
-        m_editor->setPlainText(outText);
-        delete [] outText;
+        emit ocrRequested(m_currentImage->image(), options);
     }
+}
 
-    // reset locale
-    setlocale(LC_ALL, old_ctype);
-    free(old_ctype);
+/**
+ * Cancel the running ocr job
+ */
+void MainWindow::cancelOcr()
+{
+    if (m_watcher->isWatching()) {
+        stopWatch();
+    } else if (m_ocrRunning) {
+        m_ocrWorker->cancel();
+        m_mainStatusLabel->setText("Cancelling OCR...");
+    }
 }
 
 /**
- * To detect text areas using openCV
+ * Options of an OCR job as selected in the toolbar
+ */
+OcrOptions MainWindow::ocrOptions() const
+{
+    OcrOptions options;
+    options.detectAreas = m_detectAreaCheckBox->checkState() == Qt::Checked;
+    options.detector = m_detectorSettings;
+    OcrProfile::find(m_profileComboBox->currentData().toString().toStdString(), options.profile);
+    options.profile.apply(options.detector, options.preprocess);
+    options.detector.tileSize = m_tileComboBox->currentData().toInt();
+    options.detector.scale = (float)m_scaleSpinBox->value();
+    options.detector.grouping = m_groupComboBox->currentData().toInt();
+    options.preprocess.enabled = m_preprocessCheckBox->checkState() == Qt::Checked;
+    return options;
+}
+
+/**
+ * Enable or disable the actions that must not be used while a job is running
  *
- * @param image to perform text detection on
- * @param areas holding the detected areas
- * @returns image with rectangles drawn around text images
- */
-cv::Mat MainWindow::detectTextAreas(QImage &image, std::vector<cv::Rect> &areas)
-{
-    // set up neural network
-    float confThreshold = 0.5;                              // confidence threshold
-    float nmsThreshold = 0.4;                               // non-maximum suppression
-    int inputWidth = 320;                                   // EAST requires multiple of 32
-    int inputHeight = 320;
-    std::string model = "./frozen_east_text_detection.pb";  // pretrained model data
-    // Load dnn network
-    if (m_net.empty()) {
-        m_net = cv::dnn::readNet(model);
-    }
-
-    std::vector<cv::Mat> outs;                              // output layers of the model
-    std::vector<std::string> layerNames(2);                 // names of the two layers used
-    layerNames[0] = "feature_fusion/Conv_7/Sigmoid";        // sogmoid activation - wheter given region has text or no
-    layerNames[1] = "feature_fusion/concat_3";              // feature map output - containing geometry of the image
-
-    // convert image
-    cv::Mat frame = cv::Mat(image.height(), image.width(), CV_8UC3, image.bits(), image.bytesPerLine()).clone();
-    cv::Mat blob;
-
-    // blobFromImage(input, output, scale factor, output size, training mean, swap R and B channel, crop output)
-    cv::dnn::blobFromImage( frame, blob, 1.0, cv::Size(inputWidth, inputHeight),
-        cv::Scalar(123.68, 116.78, 103.94), true, false
-    ); // cv::Scalar holds the (rgb) mean used while the model was trained
-
-    // pass input layer (blob) to dnn model and perform a round of forwarding
-    m_net.setInput(blob);
-    // outs contains the two output layers
-    m_net.forward(outs, layerNames);
-
-    // extract the two layers
-    cv::Mat scores = outs[0];
-    cv::Mat geometry = outs[1];
-
-    // decode the layers into candidate text areas (boxes) and corresponding confidences
-    std::vector<cv::RotatedRect> boxes;
-    std::vector<float> confidences;
-    decode(scores, geometry, confThreshold, boxes, confidences);
-
-    // filter the candidate areas using non-max suppression
-    std::vector<int> indices;
-    cv::dnn::NMSBoxes(boxes, confidences, confThreshold, nmsThreshold, indices);
-
-    // resizing ratio and color of boxes
-    cv::Point2f ratio((float)frame.cols / inputWidth, (float)frame.rows / inputHeight);
-    cv::Scalar red = cv::Scalar(255, 0, 0);
-
-    // iterate over indices and place rectangles
-    for (size_t i = 0; i < indices.size(); ++i) {
-        cv::RotatedRect& box = boxes[indices[i]];
-        cv::Rect area = box.boundingRect();
-
-        // reverse resizing for the rectangles
-        area.x *= ratio.x;
-        area.width *= ratio.x;
-        area.y *= ratio.y;
-        area.height *= ratio.y;
-        areas.push_back(area);
-        cv::rectangle(frame, area, red, 1);
-        QString index = QString("%1").arg(i);
-        cv::putText( frame, index.toStdString(), cv::Point2f(area.x, area.y - 2),
-            cv::FONT_HERSHEY_SIMPLEX, 0.5, red, 1
-        );
-    }
-    return frame;
-}
-
-/**
- * Extract confidences and area from dnn output layers
- * Comment: I used the following repository:
- * https://github.com/opencv/opencv/blob/master/samples/dnn/text_detection.cpp#L119
+ * @param running whether a job is running
+ */
+void MainWindow::setOcrRunning(bool running)
+{
+    m_ocrRunning = running;
+    m_ocrAction->setEnabled(!running);
+    m_detectAreaCheckBox->setEnabled(!running);
+    m_tileComboBox->setEnabled(!running);
+    m_scaleSpinBox->setEnabled(!running);
+    m_groupComboBox->setEnabled(!running);
+    m_profileComboBox->setEnabled(!running);
+    m_preprocessCheckBox->setEnabled(!running);
+    m_cancelAction->setEnabled(running);
+    m_captureAction->setEnabled(!running);
+    m_watchAction->setEnabled(!running);
+}
+
+/**
+ * Show the progress of the running job in the status bar
  *
- * @param scores of each of the detected areas (first layer output)
- * @param geometry information of the image (second layer output)
- * @param scoreThresh = confidence threshold
- * @param detections of possible area candidates
- * @param confidences for each candidate
- */
-void MainWindow::decode(const cv::Mat& scores, const cv::Mat& geometry, float scoreThresh,
-    std::vector<cv::RotatedRect>& detections, std::vector<float>& confidences)
-{
-    CV_Assert(scores.dims == 4); CV_Assert(geometry.dims == 4);
-    CV_Assert(scores.size[0] == 1); CV_Assert(scores.size[1] == 1);
-    CV_Assert(geometry.size[0] == 1);  CV_Assert(geometry.size[1] == 5);
-    CV_Assert(scores.size[2] == geometry.size[2]);
-    CV_Assert(scores.size[3] == geometry.size[3]);
-
-    detections.clear();
-    const int height = scores.size[2];
-    const int width = scores.size[3];
-    for (int y = 0; y < height; ++y) {
-        const float* scoresData = scores.ptr<float>(0, 0, y);
-        const float* x0_data = geometry.ptr<float>(0, 0, y);
-        const float* x1_data = geometry.ptr<float>(0, 1, y);
-        const float* x2_data = geometry.ptr<float>(0, 2, y);
-        const float* x3_data = geometry.ptr<float>(0, 3, y);
-        const float* anglesData = geometry.ptr<float>(0, 4, y);
-
-        for (int x = 0; x < width; ++x) {
-            float score = scoresData[x];
-            if (score < scoreThresh)
-                continue;
-
-            // Decode a prediction.
-            // Multiple by 4 because feature maps are 4 time less than input image.
-            float offsetX = x * 4.0f, offsetY = y * 4.0f;
-            float angle = anglesData[x];
-            float cosA = std::cos(angle);
-            float sinA = std::sin(angle);
-            float h = x0_data[x] + x2_data[x];
-            float w = x1_data[x] + x3_data[x];
-
-            // map the text areas (from resized image) back to the original input image
-            cv::Point2f offset(offsetX + cosA * x1_data[x] + sinA * x2_data[x],
-                offsetY - sinA * x1_data[x] + cosA * x2_data[x]);
-            cv::Point2f p1 = cv::Point2f(-sinA * h, -cosA * h) + offset;
-            cv::Point2f p3 = cv::Point2f(-cosA * w, sinA * w) + offset;
-            cv::RotatedRect r(0.5f * (p1 + p3), cv::Size2f(w, h), -angle * 180.0f / (float)CV_PI);
-            detections.push_back(r);
-            confidences.push_back(score);
-        } // end for
-    } // end for
-} // end decode
+ * @param stage of the job
+ * @param percent done of the stage
+ */
+void MainWindow::showOcrStage(QString stage, int percent)
+{
+    m_mainStatusLabel->setText(QString("%1 (%2%)").arg(stage).arg(percent));
+}
+
+/**
+ * Show the detected text areas on top of the image
+ *
+ * @param areas in image coordinates
+ */
+void MainWindow::showDetectedAreas(QVector<QRect> areas)
+{
+    if (m_currentImage != nullptr) {
+        m_currentImage->setAreas(areas);
+    }
+    m_mainStatusLabel->setText(QString("%1 text areas detected").arg(areas.size()));
+}
+
+/**
+ * Collect the text of one recognized area, the editor is updated in batches
+ *
+ * @param text recognized
+ */
+void MainWindow::appendText(int, QString text)
+{
+    m_pendingText += text;
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+/**
+ * Keeps the word boxes of one page for saveLayoutAs()
+ *
+ * @param page recognized by the running job
+ */
+void MainWindow::collectLayout(TextPage page)
+{
+    m_layoutPages.push_back(page);
+}
+
+/**
+ * Appends the pending text at the end of the editor
+ * Only the new text is laid out, the document is never set again as a whole.
+ */
+void MainWindow::flushText()
+{
+    m_flushTimer.stop();
+    if (m_pendingText.isEmpty()) {
+        return;
+    }
+    QTextCursor cursor(m_editor->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(m_pendingText);
+    m_pendingText.clear();
+}
+/**
+ * Called when a job is done
+ *
+ * @param cancelled whether the job was cancelled
+ * @param summary of the job (may be empty)
+ */
+void MainWindow::ocrFinished(bool cancelled, QString summary)
+{
+    flushText();
+    setOcrRunning(false);
+    if (cancelled) {
+        m_mainStatusLabel->setText("OCR cancelled");
+    } else {
+        m_mainStatusLabel->setText(summary.isEmpty() ? "OCR done" : "OCR done: " + summary);
+    }
+}
+
+/**
+ * Called when a job could not be run
+ *
+ * @param message describing the error
+ */
+void MainWindow::ocrFailed(QString message)
+{
+    if (m_watcher->isWatching()) {
+        stopWatch();
+    }
+    flushText();
+    setOcrRunning(false);
+    m_mainStatusLabel->setText("OCR failed");
+    QMessageBox::information(this, "Error", message);
+}
 
 /**
  * When capture screen mode is requested, minimize the GUI main window and enter the capture mode
  */
 void MainWindow::captureScreen()
 {
+    m_captureForWatch = false;
     this->setWindowState(this->windowState() | Qt::WindowMinimized);
     QTimer::singleShot(1000, this, SLOT( startCapture()) );
 }
@@ -439,7 +667,225 @@ void MainWindow::captureScreen()
  */
 void MainWindow::startCapture()
 {
-    CaptureScreen *cap = new CaptureScreen(this);
+    CaptureScreen *cap = new CaptureScreen(this, m_captureForWatch);
     cap->show();
     cap->activateWindow();
 }
+
+/**
+ * Show the statistics of the ocr result cache
+ *
+ * @param hits jobs answered from the cache
+ * @param misses jobs performed
+ */
+void MainWindow::showCacheStats(int hits, int misses)
+{
+    m_cacheStatusLabel->setText(QString("Cache: %1 hits, %2 misses").arg(hits).arg(misses));
+}
+
+/**
+ * Show the time per stage of the last job
+ *
+ * @param breakdown of the trace spans
+ */
+void MainWindow::showStageTimes(QString breakdown)
+{
+    m_traceStatusLabel->setText(breakdown);
+    m_traceStatusLabel->setToolTip(breakdown);
+}
+
+/**
+ * When watch mode is requested, select the region to be watched like a screen capture
+ */
+void MainWindow::watchScreen()
+{
+    m_captureForWatch = true;
+    this->setWindowState(this->windowState() | Qt::WindowMinimized);
+    QTimer::singleShot(1000, this, SLOT( startCapture()) );
+}
+
+/**
+ * Starts grabbing a region of a screen, changed parts are recognized again
+ *
+ * @param screen containing the region
+ * @param region in logical coordinates of the screen
+ */
+void MainWindow::watchRegion(QScreen *screen, const QRect &region)
+{
+    if (m_ocrRunning || screen == nullptr || region.isEmpty()) {
+        return;
+    }
+
+    m_flushTimer.stop();
+    m_pendingText.clear();
+    m_editor->clear();
+    m_layoutPages.clear();
+    m_watchEntries.clear();
+    m_watchFrame = SharedImage();   // the first frame gets a new item
+    m_pendingDirty.clear();
+    m_watchBusy = false;
+    m_watchOptions = ocrOptions();
+    setOcrRunning(true);
+    m_mainStatusLabel->setText("Watching region (Escape to stop)");
+    m_watcher->start(screen, region, m_watchIntervalSpinBox->value());
+}
+
+/**
+ * Stops the watch mode
+ */
+void MainWindow::stopWatch()
+{
+    m_watcher->stop();
+    m_ocrWorker->cancel();
+    m_pendingDirty.clear();
+    m_watchBusy = false;
+    setOcrRunning(false);
+    m_mainStatusLabel->setText("Watch stopped");
+}
+
+/**
+ * Called when the watched region changed: shows the frame and sends the changed parts
+ *
+ * @param frame latest grab
+ * @param dirty changed rectangles in frame coordinates
+ */
+void MainWindow::watchedRegionChanged(SharedImage frame, QVector<QRect> dirty)
+{
+    // following frames of the same size only repaint the changed tiles, the areas stay
+    const bool shown = !m_watchFrame.isNull() && m_currentImage != nullptr
+        && m_currentImage->updateRegion(frame, dirty);
+    m_watchFrame = frame;
+    m_pendingDirty += dirty;
+    if (!shown) {
+        showImage(frame, false);
+        if (m_watchOptions.detectAreas) {
+            QVector<QRect> areas;
+            for (const auto &entry : m_watchEntries) {
+                areas << entry.first;
+            }
+            m_currentImage->setAreas(areas);
+        }
+    }
+
+    // changes during a running job are collected and sent afterwards
+    if (!m_watchBusy) {
+        sendWatchJob();
+    }
+}
+
+/**
+ * Sends the pending dirty rectangles of the latest frame to the worker
+ * Known areas crossing a dirty rectangle are included completely, so they
+ * are detected and recognized again as a whole.
+ */
+void MainWindow::sendWatchJob()
+{
+    if (m_pendingDirty.isEmpty()) {
+        return;
+    }
+
+    QVector<QRect> dirty = RegionWatcher::mergeRects(m_pendingDirty);
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        for (QRect &rect : dirty) {
+            for (const auto &entry : m_watchEntries) {
+                if (rect.intersects(entry.first) && !rect.contains(entry.first)) {
+                    rect = rect.united(entry.first);
+                    grown = true;
+                }
+            }
+        }
+        dirty = RegionWatcher::mergeRects(dirty);
+    }
+
+    m_pendingDirty.clear();
+    m_watchBusy = true;
+    m_ocrWorker->jobQueued();
+    emit regionsRequested(m_watchFrame, dirty, m_watchOptions);
+}
+
+/**
+ * Called when the changed parts of the watched region are recognized
+ *
+ * @param dirty rectangles which were processed
+ * @param areas recognized within the dirty rectangles
+ * @param texts of the areas
+ */
+void MainWindow::watchedRegionRecognized(QVector<QRect> dirty, QVector<QRect> areas, QStringList texts)
+{
+    m_watchBusy = false;
+    if (!m_watcher->isWatching()) {
+        return;
+    }
+
+    // areas outside the dirty rectangles are kept, the others are replaced
+    QVector<QPair<QRect, QString>> entries;
+    for (const auto &entry : m_watchEntries) {
+        bool replaced = false;
+        for (const QRect &rect : dirty) {
+            replaced = replaced || rect.intersects(entry.first);
+        }
+        if (!replaced) {
+            entries << entry;
+        }
+    }
+    for (int i = 0; i < areas.size() && i < texts.size(); ++i) {
+        entries << qMakePair(areas[i], texts[i]);
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const QPair<QRect, QString> &a, const QPair<QRect, QString> &b) {
+        return a.first.y() != b.first.y() ? a.first.y() < b.first.y() : a.first.x() < b.first.x();
+    });
+
+    replaceWatchText(entries);
+    m_watchEntries = entries;
+    if (m_watchOptions.detectAreas && m_currentImage != nullptr) {
+        QVector<QRect> all;
+        for (const auto &entry : entries) {
+            all << entry.first;
+        }
+        m_currentImage->setAreas(all);
+    }
+    m_mainStatusLabel->setText(QString("Watching region: %1 areas recognized again").arg(areas.size()));
+
+    // changes which happened meanwhile
+    sendWatchJob();
+}
+
+/**
+ * Replaces only the text of the entries which changed in the editor
+ * Entries equal at the start and the end of both lists are left untouched.
+ *
+ * @param entries new areas and texts in reading order
+ */
+void MainWindow::replaceWatchText(const QVector<QPair<QRect, QString>> &entries)
+{
+    const QVector<QPair<QRect, QString>> &old = m_watchEntries;
+
+    int first = 0;
+    int start = 0;
+    while (first < old.size() && first < entries.size() && old[first] == entries[first]) {
+        start += old[first].second.size();
+        ++first;
+    }
+    int oldLast = old.size();
+    int newLast = entries.size();
+    while (oldLast > first && newLast > first && old[oldLast - 1] == entries[newLast - 1]) {
+        --oldLast;
+        --newLast;
+    }
+
+    int end = start;
+    for (int i = first; i < oldLast; ++i) {
+        end += old[i].second.size();
+    }
+    QString text;
+    for (int i = first; i < newLast; ++i) {
+        text += entries[i].second;
+    }
+
+    QTextCursor cursor(m_editor->document());
+    cursor.setPosition(start);
+    cursor.setPosition(end, QTextCursor::KeepAnchor);
+    cursor.insertText(text);
+}
@@ -17,16 +17,24 @@
 #include <QGraphicsScene>
 #include <QGraphicsView>
 #include <QStatusBar>
-#include <QGraphicsPixmapItem>
 #include <QPixmap>
-#include <QTextEdit>
+#include <QPlainTextEdit>
 #include <QCheckBox>
 #include <QTimer>
+#include <QThread>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+#include <QScreen>
+#include <QPair>
 
 // local includes
-#include "tesseract/baseapi.h"
-#include "opencv2/opencv.hpp"
-#include "opencv2/dnn.hpp"
+#include "OcrWorker.h"
+#include "SharedImage.h"
+#include "ImageItem.h"
+#include "RegionWatcher.h"
+#include "DocumentReader.h"
+#include "TextLayout.h"
 
 
 /**
@@ -50,26 +58,55 @@ class MainWindow : public QMainWindow
 public:
     explicit MainWindow(QWidget *parent=nullptr);
     ~MainWindow();
-    void showImage(QPixmap);    // show image from screen capture
+    void showImage(const SharedImage &, bool resetView = true);    // show image from screen capture
+    void watchRegion(QScreen *screen, const QRect &region);        // start the watch mode
+    void setDetectorSettings(const DetectorSettings &settings) { m_detectorSettings = settings; }
 
 private:
     void initUI();              // all widgets (without actions)
     void createActions();       // to create all the actions
     void showImage(QString);    // show image from a path
-    void showImage(cv::Mat);    // show image with openCV text areas
     void setupShortcuts();      // some key shortcuts
+    void setOcrRunning(bool);   // enable/disable actions while a job is running
+    OcrOptions ocrOptions() const;              // options selected in the toolbar
+    void sendWatchJob();        // recognizes the pending dirty rectangles of the watched region
+    void replaceWatchText(const QVector<QPair<QRect, QString>> &entries);
 
-    void decode(const cv::Mat& scores, const cv::Mat& geometry, float scoreThresh,
-        std::vector<cv::RotatedRect>& detections, std::vector<float>& confidences);
-    cv::Mat detectTextAreas(QImage &image, std::vector<cv::Rect>&);
+signals:
+    void ocrRequested(SharedImage image, OcrOptions options);
+    void documentRequested(QString path, OcrOptions options);
+    void regionsRequested(SharedImage frame, QVector<QRect> dirty, OcrOptions options);
+    void preloadRequested(OcrOptions options);
 
 private slots:
     void openImage();
     void saveImageAs();
     void saveTextAs();
+    void saveLayoutAs();
     void extractText();
     void captureScreen();
     void startCapture();
+    void watchScreen();
+    void stopWatch();
+    void watchedRegionChanged(SharedImage frame, QVector<QRect> dirty);
+    void watchedRegionRecognized(QVector<QRect> dirty, QVector<QRect> areas, QStringList texts);
+    void cancelOcr();
+    void showOcrStage(QString stage, int percent);
+    void showDetectedAreas(QVector<QRect> areas);
+    void appendText(int index, QString text);
+    void collectLayout(TextPage page);
+    void flushText();
+    void ocrFinished(bool cancelled, QString summary);
+    void ocrFailed(QString message);
+    void showCacheStats(int hits, int misses);
+    void showStageTimes(QString breakdown);
+    void saveTraceAs();
+    void zoomIn();
+    void zoomOut();
+    void fitImage();
+    void applyProfile(int index);
+    void preloadEngines();
+    void enginesPreloaded(QString summary);
 
 private:
     QMenu *m_fileMenu;
@@ -79,24 +116,53 @@ private:
     QGraphicsScene *m_imageScene;
     QGraphicsView *m_imageView;
 
-    QTextEdit *m_editor;
+    QPlainTextEdit *m_editor;                 // lays out only the visible blocks
+    QString m_pendingText;                    // text not yet appended to the editor
+    QTimer m_flushTimer;                      // appends the pending text in batches
+    std::vector<TextPage> m_layoutPages;      // word boxes of the last job, per page
 
     QStatusBar *m_mainStatusBar;
     QLabel *m_mainStatusLabel;
+    QLabel *m_cacheStatusLabel;               // hits/misses of the ocr result cache
+    QLabel *m_traceStatusLabel;               // time per stage of the last job
 
     QAction *m_openAction;
     QAction *m_saveImageAsAction;
     QAction *m_saveTextAsAction;
+    QAction *m_saveLayoutAsAction;            // word boxes and confidences as JSON or hOCR
+    QAction *m_saveTraceAsAction;             // exports the trace spans of all jobs
     QAction *m_exitAction;
     QAction *m_captureAction;
     QAction *m_ocrAction;                     // action to trigger optical caracter recognition
+    QAction *m_cancelAction;                  // action to cancel a running ocr job
+    QAction *m_watchAction;                   // selects a region to be watched
+    QSpinBox *m_watchIntervalSpinBox;         // time between two grabs of the watched region
+    QAction *m_zoomInAction;
+    QAction *m_zoomOutAction;
+    QAction *m_fitAction;                     // scales the image to the size of the view
     QCheckBox *m_detectAreaCheckBox;
+    QComboBox *m_profileComboBox;             // speed/accuracy profile (presets grouping and preprocessing)
+    QCheckBox *m_preprocessCheckBox;          // grayscale, deskew and binarization prior OCR
+    QComboBox *m_tileComboBox;                // whole frame or tile size of the text area detection
+    QDoubleSpinBox *m_scaleSpinBox;           // scaling of the image prior tiled detection
+    QComboBox *m_groupComboBox;               // detected boxes are recognized as words, lines or paragraphs
 
     QString m_currentImagePath;
-    QGraphicsPixmapItem *m_currentImage;
-
-    tesseract::TessBaseAPI *m_tesseractAPI;   // interface to handle ocr
-    cv::dnn::Net m_net;                       // deep neural network instance containing pretrained EAST model
+    ImageItem *m_currentImage;                // shown image, shared with the ocr jobs
+    int m_currentPageCount;                   // pages of the opened document (first one is shown)
+
+    DetectorSettings m_detectorSettings;      // base settings of the text area detection
+    QThread m_ocrThread;                      // background thread running the ocr jobs
+    OcrWorker *m_ocrWorker;                   // detection and recognition engines (living in m_ocrThread)
+    bool m_ocrRunning;
+
+    bool m_captureForWatch;                   // the running capture selects a region to be watched
+    RegionWatcher *m_watcher;                 // grabs the watched region
+    OcrOptions m_watchOptions;
+    SharedImage m_watchFrame;                 // latest grab of the watched region
+    QVector<QRect> m_pendingDirty;            // changed rectangles not yet sent to the worker
+    bool m_watchBusy;                         // a watch job is running
+    QVector<QPair<QRect, QString>> m_watchEntries;  // areas and text of the watched region (reading order)
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,98 @@
+// system includes
+#include <fstream>
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// local includes
+#include "ModelStore.h"
+
+MappedFile::~MappedFile()
+{
+#ifdef __unix__
+    if (m_mapped) {
+        munmap(const_cast<char*>(m_data), m_size);
+        return;
+    }
+#endif
+    delete [] m_data;
+}
+
+/**
+ * The store shared by all engines of the process
+ */
+ModelStore &ModelStore::instance()
+{
+    static ModelStore store;
+    return store;
+}
+
+/**
+ * Maps a model file, every file is only mapped once
+ *
+ * @param path of the file
+ * @returns mapped file, nullptr if the file can not be read
+ */
+std::shared_ptr<const MappedFile> ModelStore::map(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_files.find(path);
+    if (found != m_files.end()) {
+        return found->second;
+    }
+
+    std::shared_ptr<MappedFile> file(new MappedFile());
+#ifdef __unix__
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            file->m_data = static_cast<const char*>(data);
+            file->m_size = (size_t)info.st_size;
+            file->m_mapped = true;
+        }
+    }
+    close(fd);
+#endif
+    if (file->m_data == nullptr) {
+        // no mmap, the file is read once into memory
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        std::streamoff size = in ? (std::streamoff)in.tellg() : 0;
+        if (size <= 0) {
+            return nullptr;
+        }
+        char *data = new char[(size_t)size];
+        in.seekg(0);
+        if (!in.read(data, size)) {
+            delete [] data;
+            return nullptr;
+        }
+        file->m_data = data;
+        file->m_size = (size_t)size;
+    }
+
+    m_files[path] = file;
+    return file;
+}
+
+/**
+ * Total size of all mapped files
+ *
+ * @returns bytes
+ */
+size_t ModelStore::mappedBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (const auto &file : m_files) {
+        bytes += file.second->size();
+    }
+    return bytes;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file ModelStore.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef MODELSTORE_H
+#define MODELSTORE_H
+
+// system includes
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * Read-only model file mapped into memory
+ */
+class MappedFile
+{
+public:
+    ~MappedFile();
+
+    const char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    friend class ModelStore;
+    MappedFile() : m_data(nullptr), m_size(0), m_mapped(false) {}
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *m_data;
+    size_t m_size;
+    bool m_mapped;              // false: m_data was allocated (no mmap on this platform)
+};
+
+/**
+ * Process wide store of the model files (traineddata, EAST network)
+ *
+ * Every file is memory mapped once, all engine instances are initialized
+ * from the same read-only pages instead of reading the file again. The
+ * mappings are kept until the end of the process, so a pool of recognizers
+ * or a profile switch back and forth never touches the disk twice. The
+ * store is thread safe.
+ */
+class ModelStore
+{
+public:
+    static ModelStore &instance();
+
+    std::shared_ptr<const MappedFile> map(const std::string &path);   // nullptr if not readable
+    size_t mappedBytes() const;
+
+private:
+    ModelStore() {}
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::shared_ptr<const MappedFile>> m_files;
+};
+
+#endif // MODELSTORE_H
@@ -0,0 +1,115 @@
+// system includes
+#include <fstream>
+
+// local includes
+#include "OcrProfile.h"
+
+/**
+ * The built-in profiles, from fastest to most accurate
+ *
+ * @returns fast, balanced and best
+ */
+std::vector<OcrProfile> OcrProfile::all()
+{
+    // integer models, raw lines without layout analysis, binarized and at most 2000 pixels
+    OcrProfile fast;
+    fast.name = "fast";
+    fast.dataVariant = "fast";
+    fast.areaPageSegMode = tesseract::PSM_RAW_LINE;
+    fast.confThreshold = 0.6f;
+    fast.preprocess = true;
+    fast.deskew = false;
+    fast.maxSide = 2000;
+
+    // the former defaults, but lines are recognized as single lines
+    OcrProfile balanced;
+
+    // float models, finer detection, whole paragraphs give the language model more context
+    OcrProfile best;
+    best.name = "best";
+    best.dataVariant = "best";
+    best.pageSegMode = tesseract::PSM_AUTO;
+    best.areaPageSegMode = tesseract::PSM_SINGLE_BLOCK;
+    best.grouping = TextGrouper::Paragraphs;
+    best.inputSize = 640;
+    best.confThreshold = 0.4f;
+    best.nmsThreshold = 0.3f;
+
+    return {fast, balanced, best};
+}
+
+/**
+ * Looks up a built-in profile by name
+ *
+ * @param name of the profile
+ * @param profile found
+ * @returns false if there is no such profile
+ */
+bool OcrProfile::find(const std::string &name, OcrProfile &profile)
+{
+    for (const OcrProfile &candidate : all()) {
+        if (candidate.name == name) {
+            profile = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Applies the detection and preprocessing part of the profile
+ * Backend, target, tiling and whether to preprocess at all are left as they are.
+ *
+ * @param detector settings to be changed
+ * @param preprocess settings to be changed
+ */
+void OcrProfile::apply(DetectorSettings &detector, PreprocessSettings &preprocess) const
+{
+    detector.inputWidth = inputSize;
+    detector.inputHeight = inputSize;
+    detector.confThreshold = confThreshold;
+    detector.nmsThreshold = nmsThreshold;
+    detector.grouping = grouping;
+    preprocess.deskew = deskew;
+    preprocess.maxSide = maxSide;
+}
+
+/**
+ * Directory of the tessdata variant of the profile
+ *
+ * @param tessdata path of the plain tessdata directory
+ * @param language of the traineddata
+ * @returns tessdata_<variant> next to tessdata if it holds the language, else tessdata
+ */
+std::string OcrProfile::dataPath(const std::string &tessdata, const std::string &language) const
+{
+    if (dataVariant.empty()) {
+        return tessdata;
+    }
+    std::string base = tessdata;
+    while (base.size() > 1 && base.back() == '/') {
+        base.pop_back();
+    }
+    std::string variant = base + "_" + dataVariant;
+    std::ifstream traineddata(variant + "/" + language + ".traineddata");
+    return traineddata.good() ? variant : tessdata;
+}
+
+/**
+ * Page segmentation mode of the detected areas
+ * The mode of the profile fits its own grouping, other groupings get the matching mode.
+ *
+ * @param grouping TextGrouper::Mode the areas were grouped with
+ * @returns tesseract::PageSegMode
+ */
+int OcrProfile::areaPageSegModeFor(int grouping) const
+{
+    if (grouping == this->grouping) {
+        return areaPageSegMode;
+    }
+    switch (grouping) {
+    case TextGrouper::Words: return tesseract::PSM_SINGLE_WORD;
+    case TextGrouper::Lines: return tesseract::PSM_SINGLE_LINE;
+    default: return tesseract::PSM_SINGLE_BLOCK;
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * @file OcrProfile.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef OCRPROFILE_H
+#define OCRPROFILE_H
+
+// system includes
+#include <string>
+#include <vector>
+
+// local includes
+#include "TextDetector.h"
+#include "TextRecognizer.h"
+#include "Preprocessor.h"
+
+/**
+ * Named trade-off between speed and accuracy of the whole pipeline
+ *
+ * A profile bundles the engine configuration (tessdata variant, OCR engine
+ * mode, page segmentation of whole images and of detected areas) with the
+ * detection settings (network input size, thresholds, grouping) and the
+ * preprocessing (downscaling, deskew). The built-in profiles are "fast",
+ * "balanced" (the former defaults) and "best". The tessdata variants are
+ * expected next to the tessdata directory (tessdata_fast, tessdata_best),
+ * the plain tessdata is used if a variant is not installed.
+ */
+struct OcrProfile
+{
+    std::string name = "balanced";
+    std::string dataVariant;            // suffix of the tessdata directory ("fast": tessdata_fast)
+    int engineMode = tesseract::OEM_LSTM_ONLY;          // tesseract::OcrEngineMode
+    int pageSegMode = tesseract::PSM_SINGLE_BLOCK;      // tesseract::PageSegMode of whole images
+    int areaPageSegMode = tesseract::PSM_SINGLE_LINE;   // page segmentation of the areas of grouping
+    int grouping = TextGrouper::Lines;
+    int inputSize = 320;                // EAST input width and height (multiple of 32)
+    float confThreshold = 0.5f;
+    float nmsThreshold = 0.4f;
+    bool preprocess = false;            // grayscale and binarization
+    bool deskew = true;
+    int maxSide = 0;                    // larger images are downscaled (with preprocessing only)
+
+    static std::vector<OcrProfile> all();
+    static bool find(const std::string &name, OcrProfile &profile);
+
+    void apply(DetectorSettings &detector, PreprocessSettings &preprocess) const;
+    std::string dataPath(const std::string &tessdata, const std::string &language) const;
+    int areaPageSegModeFor(int grouping) const;
+};
+
+#endif // OCRPROFILE_H
@@ -0,0 +1,474 @@
+// system includes
+#include <QHostAddress>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <algorithm>
+#include <iostream>
+
+// local includes
+#include "OcrService.h"
+#include "TextGrouper.h"
+#include "Tracer.h"
+
+/**
+ * Value below which the given fraction of the samples lies
+ *
+ * @param samples unsorted, copied
+ * @param p fraction between 0 and 1
+ * @returns percentile, 0 without samples
+ */
+static double percentile(std::vector<double> samples, double p)
+{
+    if (samples.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(samples.size() - 1, (size_t)(p * (samples.size() - 1) + 0.5));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+/**
+ * Reason phrase of the status codes used by the service
+ */
+static const char *reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 503: return "Service Unavailable";
+    default: return "Internal Server Error";
+    }
+}
+
+OcrService::OcrService(const ServiceOptions &options, QObject *parent) : QObject(parent),
+    m_options(options), m_nextId(0), m_jobs(std::max(1, options.maxQueue)), m_queued(0), m_active(0),
+    m_completed(0), m_failed(0), m_rejected(0), m_latencyNext(0)
+{
+    m_options.maxQueue = std::max(1, m_options.maxQueue);   // same bound as the job queue
+    connect(&m_localServer, SIGNAL(newConnection()), this, SLOT(acceptLocal()));
+    connect(&m_tcpServer, SIGNAL(newConnection()), this, SLOT(acceptTcp()));
+    // results are emitted by the worker threads and written by the thread owning the sockets
+    connect(this, SIGNAL(finished(quint64,int,QByteArray)), this, SLOT(reply(quint64,int,QByteArray)),
+        Qt::QueuedConnection);
+}
+
+/**
+ * Finishes the queued requests and stops the workers
+ */
+OcrService::~OcrService()
+{
+    m_jobs.close();
+    for (std::thread &worker : m_workers) {
+        worker.join();
+    }
+    if (m_batcher) {
+        m_batcher->stop();
+    }
+}
+
+/**
+ * Loads the engines of all workers, starts the detection batcher and listens
+ * on the configured socket and port
+ *
+ * @returns false if an engine could not be loaded or no socket could be opened
+ */
+bool OcrService::start()
+{
+    const BatchOptions &engines = m_options.engines;
+    const OcrProfile &profile = engines.profile;
+    const int threadCount = std::max(1, engines.threads);
+    for (int i = 0; i < threadCount; ++i) {
+        std::unique_ptr<TextRecognizer> recognizer(new TextRecognizer());
+        if (!recognizer->init(profile.dataPath(engines.tessdata, engines.language), engines.language,
+                profile.engineMode)) {
+            std::cerr << "Failed to initialize tesseract." << std::endl;
+            return false;
+        }
+        recognizer->setPageSegModes(profile.pageSegMode, profile.areaPageSegModeFor(engines.detector.grouping));
+        m_recognizers.push_back(std::move(recognizer));
+    }
+
+    // a single network for all workers, concurrent requests share its forward passes
+    if (engines.detectAreas) {
+        m_batcher.reset(new DetectionBatcher(engines.detector, engines.detectBatch, engines.batchLatencyMs));
+        if (!m_batcher->start()) {
+            std::cerr << "Failed to load " << engines.detector.model << std::endl;
+            return false;
+        }
+    }
+
+    if (!m_options.socketPath.isEmpty()) {
+        // a socket file left behind by a killed service would block listen()
+        QLocalServer::removeServer(m_options.socketPath);
+        if (!m_localServer.listen(m_options.socketPath)) {
+            std::cerr << "Can't listen on " << m_options.socketPath.toStdString() << ": "
+                      << m_localServer.errorString().toStdString() << std::endl;
+            return false;
+        }
+        std::cout << "listening on " << m_localServer.fullServerName().toStdString() << std::endl;
+    }
+    if (m_options.port > 0) {
+        if (!m_tcpServer.listen(QHostAddress::LocalHost, m_options.port)) {
+            std::cerr << "Can't listen on port " << m_options.port << ": "
+                      << m_tcpServer.errorString().toStdString() << std::endl;
+            return false;
+        }
+        std::cout << "listening on http://127.0.0.1:" << m_options.port << std::endl;
+    }
+    if (!m_localServer.isListening() && !m_tcpServer.isListening()) {
+        std::cerr << "Neither a socket nor a port is given." << std::endl;
+        return false;
+    }
+
+    m_started = std::chrono::steady_clock::now();
+    for (const std::unique_ptr<TextRecognizer> &recognizer : m_recognizers) {
+        TextRecognizer *engine = recognizer.get();
+        m_workers.emplace_back([this, engine]() { work(*engine); });
+    }
+    std::cout << threadCount << " workers, detection "
+              << (m_batcher ? "batched up to " + std::to_string(engines.detectBatch) + " images" : std::string("off"))
+              << std::endl;
+    return true;
+}
+
+/**
+ * Accepts the pending connections on the Unix domain socket
+ */
+void OcrService::acceptLocal()
+{
+    while (QLocalSocket *connection = m_localServer.nextPendingConnection()) {
+        addConnection(connection);
+    }
+}
+
+/**
+ * Accepts the pending connections on the TCP port
+ */
+void OcrService::acceptTcp()
+{
+    while (QTcpSocket *connection = m_tcpServer.nextPendingConnection()) {
+        addConnection(connection);
+    }
+}
+
+/**
+ * Starts reading the request of a new connection
+ *
+ * @param connection local or TCP socket
+ */
+void OcrService::addConnection(QIODevice *connection)
+{
+    m_buffers.insert(connection, QByteArray());
+    connect(connection, SIGNAL(readyRead()), this, SLOT(readRequest()));
+    connect(connection, SIGNAL(disconnected()), this, SLOT(connectionClosed()));
+}
+
+/**
+ * Collects the bytes of a request until header and body are complete
+ * One request is served per connection, the connection is closed after the response.
+ */
+void OcrService::readRequest()
+{
+    QIODevice *connection = qobject_cast<QIODevice*>(sender());
+    if (!connection) {
+        return;
+    }
+    if (!m_buffers.contains(connection)) {
+        connection->readAll();      // request already complete, the rest is ignored
+        return;
+    }
+    QByteArray &buffer = m_buffers[connection];
+    buffer += connection->readAll();
+
+    const int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (buffer.size() > 64 * 1024) {
+            m_buffers.remove(connection);
+            respond(connection, 400, "Header too large\n");
+        }
+        return;
+    }
+
+    const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() < 2) {
+        m_buffers.remove(connection);
+        respond(connection, 400, "Malformed request line\n");
+        return;
+    }
+    qint64 contentLength = 0;
+    for (int i = 1; i < lines.size(); ++i) {
+        const int colon = lines[i].indexOf(':');
+        if (colon > 0 && lines[i].left(colon).trimmed().toLower() == "content-length") {
+            contentLength = lines[i].mid(colon + 1).trimmed().toLongLong();
+        }
+    }
+    if (contentLength < 0 || contentLength > MAX_REQUEST_BYTES) {
+        m_buffers.remove(connection);
+        respond(connection, 413, "Image too large\n");
+        return;
+    }
+    if (buffer.size() - headerEnd - 4 < contentLength) {
+        return;                     // wait for the rest of the body
+    }
+
+    const QByteArray body = buffer.mid(headerEnd + 4, (int)contentLength);
+    m_buffers.remove(connection);
+
+    // the query string is not used
+    QByteArray path = requestLine[1];
+    const int query = path.indexOf('?');
+    if (query >= 0) {
+        path.truncate(query);
+    }
+    handleRequest(connection, requestLine[0], path, body);
+}
+
+/**
+ * Dispatches a complete request
+ *
+ * @param connection to answer on
+ * @param method GET or POST
+ * @param path without query
+ * @param body encoded image of an OCR request
+ */
+void OcrService::handleRequest(QIODevice *connection, const QByteArray &method, const QByteArray &path,
+    const QByteArray &body)
+{
+    if (path == "/metrics") {
+        if (method != "GET") {
+            respond(connection, 405, "Use GET /metrics\n");
+        } else {
+            respond(connection, 200, metrics(), "application/json");
+        }
+        return;
+    }
+    if (path != "/ocr") {
+        respond(connection, 404, "Unknown path, use POST /ocr or GET /metrics\n");
+        return;
+    }
+    if (method != "POST") {
+        respond(connection, 405, "Use POST /ocr with the image as body\n");
+        return;
+    }
+
+    // only this thread queues, so the queue can not be full once the check passed
+    if (m_queued.load() >= m_options.maxQueue) {
+        ++m_rejected;
+        respond(connection, 503, "Queue full, try again later\n");
+        return;
+    }
+    Job job;
+    job.id = ++m_nextId;
+    job.data = body;
+    job.received = std::chrono::steady_clock::now();
+    m_pending.insert(job.id, connection);
+    ++m_queued;
+    m_jobs.push(std::move(job));
+}
+
+/**
+ * Writes the result of a worker to the waiting connection
+ *
+ * @param id of the request
+ * @param status HTTP status code
+ * @param body recognized text or error message
+ */
+void OcrService::reply(quint64 id, int status, QByteArray body)
+{
+    QPointer<QIODevice> connection = m_pending.take(id);
+    if (connection) {
+        respond(connection, status, body);
+    }
+}
+
+/**
+ * Writes a complete response and closes the connection once it is sent
+ *
+ * @param connection to answer on
+ * @param status HTTP status code
+ * @param body of the response
+ * @param contentType of the body
+ */
+void OcrService::respond(QIODevice *connection, int status, const QByteArray &body, const QByteArray &contentType)
+{
+    QByteArray response = "HTTP/1.0 " + QByteArray::number(status) + " " + reasonPhrase(status) + "\r\n"
+        + "Content-Type: " + contentType + "\r\n"
+        + "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+        + "Connection: close\r\n\r\n";
+    connection->write(response + body);
+
+    // both wait until the pending data is written
+    if (QLocalSocket *local = qobject_cast<QLocalSocket*>(connection)) {
+        local->disconnectFromServer();
+    } else if (QAbstractSocket *tcp = qobject_cast<QAbstractSocket*>(connection)) {
+        tcp->disconnectFromHost();
+    }
+}
+
+/**
+ * Releases a closed connection, a pending result for it is dropped
+ */
+void OcrService::connectionClosed()
+{
+    QIODevice *connection = qobject_cast<QIODevice*>(sender());
+    if (connection) {
+        m_buffers.remove(connection);
+        connection->deleteLater();
+    }
+}
+
+/**
+ * Worker thread: decodes and recognizes the queued images until the service stops
+ *
+ * @param recognizer owned by this worker
+ */
+void OcrService::work(TextRecognizer &recognizer)
+{
+    Tracer::instance().setThreadName("service worker");
+    Job job;
+    while (m_jobs.pop(job)) {
+        --m_queued;
+        ++m_active;
+        const auto started = std::chrono::steady_clock::now();
+
+        int status = 200;
+        QByteArray body;
+        SharedImage image;
+        {
+            TraceSpan span("load_image");
+            image = SharedImage(QImage::fromData(job.data));
+        }
+        std::string text;
+        if (image.isNull()) {
+            status = 400;
+            body = "Can't read image\n";
+            ++m_failed;
+        } else if (!recognize(recognizer, image, text)) {
+            status = 500;
+            body = "Detection failed\n";
+            ++m_failed;
+        } else {
+            body = QByteArray::fromStdString(text);
+        }
+
+        const auto done = std::chrono::steady_clock::now();
+        recordLatency(std::chrono::duration<double, std::milli>(started - job.received).count(),
+            std::chrono::duration<double, std::milli>(done - job.received).count());
+        ++m_completed;
+        --m_active;
+        emit finished(job.id, status, body);
+    }
+}
+
+/**
+ * Runs the pipeline of the batch mode on one image
+ *
+ * @param recognizer of the calling worker
+ * @param image to be recognized
+ * @param text recognized text
+ * @returns false if the detection failed
+ */
+bool OcrService::recognize(TextRecognizer &recognizer, const SharedImage &image, std::string &text)
+{
+    const BatchOptions &engines = m_options.engines;
+    cv::Mat frame = image.mat();
+    cv::Mat detectionFrame = frame;
+    PreprocessedFrame preprocessed;     // owns the buffers of the preprocessed frames
+    if (engines.preprocess.enabled) {
+        TraceSpan span("preprocess");
+        preprocessed = Preprocessor::process(frame, engines.preprocess);
+        detectionFrame = preprocessed.gray;
+        frame = preprocessed.binary;
+    }
+
+    recognizer.setImage(frame);
+    if (!m_batcher) {
+        TraceSpan span("recognize");
+        text = recognizer.recognize();
+        return true;
+    }
+
+    std::vector<cv::Rect> areas;
+    {
+        TraceSpan span("detect");
+        try {
+            areas = m_batcher->submit(detectionFrame).get();
+        } catch (const cv::Exception &e) {
+            std::cerr << "Detection failed: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    {
+        TraceSpan span("group");
+        areas = TextGrouper::group(areas, (TextGrouper::Mode)engines.detector.grouping);
+    }
+    TraceSpan span("recognize");
+    text = recognizer.recognize(areas);
+    return true;
+}
+
+/**
+ * Keeps the latency of a finished request in the window of recent requests
+ *
+ * @param queueMs time from receiving the request until a worker took it
+ * @param totalMs time from receiving the request until the result was ready
+ */
+void OcrService::recordLatency(double queueMs, double totalMs)
+{
+    std::lock_guard<std::mutex> lock(m_latencyMutex);
+    if (m_totalMs.size() < (size_t)LATENCY_WINDOW) {
+        m_totalMs.push_back(totalMs);
+        m_queueMs.push_back(queueMs);
+    } else {
+        m_totalMs[m_latencyNext] = totalMs;
+        m_queueMs[m_latencyNext] = queueMs;
+    }
+    m_latencyNext = (m_latencyNext + 1) % LATENCY_WINDOW;
+}
+
+/**
+ * Current state of the service
+ *
+ * @returns JSON with queue depth, counters and the latency percentiles of the recent requests
+ */
+QByteArray OcrService::metrics() const
+{
+    std::vector<double> totalMs;
+    std::vector<double> queueMs;
+    {
+        std::lock_guard<std::mutex> lock(m_latencyMutex);
+        totalMs = m_totalMs;
+        queueMs = m_queueMs;
+    }
+
+    QJsonObject latency;
+    latency["p50"] = percentile(totalMs, 0.5);
+    latency["p90"] = percentile(totalMs, 0.9);
+    latency["p99"] = percentile(totalMs, 0.99);
+    latency["max"] = percentile(totalMs, 1.0);
+    QJsonObject wait;
+    wait["p50"] = percentile(queueMs, 0.5);
+    wait["p99"] = percentile(queueMs, 0.99);
+
+    QJsonObject result;
+    result["uptime_s"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_started).count();
+    result["workers"] = (int)m_workers.size();
+    result["queue_depth"] = m_queued.load();
+    result["active"] = m_active.load();
+    result["max_queue"] = m_options.maxQueue;
+    result["completed"] = (double)m_completed.load();
+    result["failed"] = (double)m_failed.load();
+    result["rejected"] = (double)m_rejected.load();
+    result["detection_batch_size"] = m_batcher ? m_batcher->averageBatchSize() : 0.0;
+    result["latency_window"] = (int)totalMs.size();
+    result["latency_ms"] = latency;
+    result["queue_ms"] = wait;
+    return QJsonDocument(result).toJson(QJsonDocument::Indented);
+}
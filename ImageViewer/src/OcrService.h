@@ -0,0 +1,126 @@
+/**
+ * @file OcrService.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef OCRSERVICE_H
+#define OCRSERVICE_H
+
+// system includes
+#include <QByteArray>
+#include <QHash>
+#include <QLocalServer>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTcpServer>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// local includes
+#include "BatchProcessor.h"
+#include "BoundedQueue.h"
+#include "DetectionBatcher.h"
+#include "SharedImage.h"
+#include "TextRecognizer.h"
+
+/**
+ * Options of the OCR service
+ */
+struct ServiceOptions
+{
+    BatchOptions engines;           // pipeline and worker pool (inputs and outputDir are not used)
+    QString socketPath;             // Unix domain socket (empty: none)
+    quint16 port = 0;               // HTTP port on localhost (0: none)
+    int maxQueue = 64;              // requests waiting beyond that are refused
+};
+
+/**
+ * Long running local OCR server
+ *
+ * The engines are loaded once at start: one Tesseract API per worker thread
+ * and one EAST network shared through a DetectionBatcher, so requests
+ * arriving at the same time are detected together with a single forward
+ * pass. Clients speak plain HTTP/1.0 over a Unix domain socket or a
+ * localhost TCP port:
+ *
+ *   POST /ocr       body: encoded image (PNG, JPEG, TIFF, ...), returns the text
+ *   GET  /metrics   queue depth, counters and latency percentiles as JSON
+ *
+ * The sockets are served by the event loop of the calling thread, the OCR
+ * runs in the worker threads. When maxQueue requests are waiting, further
+ * ones are answered with 503 instead of growing the queue without bound.
+ */
+class OcrService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OcrService(const ServiceOptions &options, QObject *parent=nullptr);
+    ~OcrService();
+
+    bool start();                   // loads the engines and starts listening
+
+signals:
+    void finished(quint64 id, int status, QByteArray body);     // emitted by the workers
+
+private slots:
+    void acceptLocal();
+    void acceptTcp();
+    void readRequest();
+    void connectionClosed();
+    void reply(quint64 id, int status, QByteArray body);
+
+private:
+    struct Job {
+        quint64 id = 0;
+        QByteArray data;            // encoded image, decoded by the worker
+        std::chrono::steady_clock::time_point received;
+    };
+
+    static const int MAX_REQUEST_BYTES = 64 * 1024 * 1024;
+    static const int LATENCY_WINDOW = 1024;
+
+    void addConnection(QIODevice *connection);
+    void handleRequest(QIODevice *connection, const QByteArray &method, const QByteArray &path,
+        const QByteArray &body);
+    void respond(QIODevice *connection, int status, const QByteArray &body,
+        const QByteArray &contentType="text/plain; charset=utf-8");
+    void work(TextRecognizer &recognizer);
+    bool recognize(TextRecognizer &recognizer, const SharedImage &image, std::string &text);
+    void recordLatency(double queueMs, double totalMs);
+    QByteArray metrics() const;
+
+private:
+    ServiceOptions m_options;
+    QLocalServer m_localServer;
+    QTcpServer m_tcpServer;
+    QHash<QIODevice*, QByteArray> m_buffers;            // received bytes of unfinished requests
+    QHash<quint64, QPointer<QIODevice>> m_pending;      // connections waiting for their result
+    quint64 m_nextId;
+
+    BoundedQueue<Job> m_jobs;
+    std::vector<std::unique_ptr<TextRecognizer>> m_recognizers;    // one per worker thread
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<DetectionBatcher> m_batcher;        // shared micro-batched detection
+    std::chrono::steady_clock::time_point m_started;
+
+    std::atomic<int> m_queued;      // requests waiting for a worker
+    std::atomic<int> m_active;      // requests being processed
+    std::atomic<long> m_completed;
+    std::atomic<long> m_failed;     // images that could not be read or detected
+    std::atomic<long> m_rejected;   // refused because the queue was full
+
+    mutable std::mutex m_latencyMutex;
+    std::vector<double> m_totalMs;  // latency of the last LATENCY_WINDOW requests (ring buffer)
+    std::vector<double> m_queueMs;  // time the same requests waited for a worker
+    size_t m_latencyNext;
+};
+
+#endif // OCRSERVICE_H
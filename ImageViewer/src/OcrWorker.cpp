@@ -0,0 +1,561 @@
+// system includes
+#include <algorithm>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <QElapsedTimer>
+#include <QThread>
+#include <thread>
+
+// local includes
+#include "OcrWorker.h"
+#include "Tracer.h"
+#include "BoundedQueue.h"
+#include "DocumentReader.h"
+#include "ModelStore.h"
+
+OcrWorker::OcrWorker(QObject *parent) : QObject(parent),
+    m_parallelRecognizer(QThread::idealThreadCount()), m_language("eng"), m_queuedJobs(0), m_cancelledJobs(0), m_job(0), m_lastPercent(-1)
+{
+    // report tesseract's progress and forward the cancel request
+    m_recognizer.setMonitor([this](int percent) {
+        if (percent != m_lastPercent) {
+            m_lastPercent = percent;
+            emit stageChanged(m_stage, percent);
+        }
+        return !isCancelled();
+    });
+}
+
+OcrWorker::~OcrWorker()
+{
+}
+
+/**
+ * Announces a job which is about to be queued
+ * The flag is not reset when a job starts, so a cancel() issued while the
+ * job is still waiting in the queue (e.g. behind the preload) is not lost.
+ */
+void OcrWorker::jobQueued()
+{
+    ++m_queuedJobs;
+}
+
+/**
+ * Requests the running job and all queued ones to stop as soon as possible
+ */
+void OcrWorker::cancel()
+{
+    m_cancelledJobs = std::max(m_queuedJobs.load(), m_job.load());
+    m_parallelRecognizer.cancel();
+}
+
+/**
+ * Takes the next job number (in the worker thread, jobs run in the order they were queued)
+ * The pool only keeps a cancel request which applies to this job.
+ */
+void OcrWorker::startJob()
+{
+    ++m_job;
+    m_parallelRecognizer.resetCancel();
+    if (isCancelled()) {
+        m_parallelRecognizer.cancel();
+    }
+}
+
+/**
+ * Initializes the Tesseract API for the profile of a job (in the worker thread)
+ * The engines are only initialized again if the profile needs other traineddata.
+ *
+ * @param options of the job (profile and grouping)
+ * @param parallel also initialize the pool used for parallel area recognition
+ * @returns false if tesseract could not be initialized
+ */
+bool OcrWorker::initEngines(const OcrOptions &options, bool parallel)
+{
+    const OcrProfile &profile = options.profile;
+    const std::string language = m_language.toStdString();
+    const std::string dataPath = profile.dataPath(TESSDATA_PATH, language);
+    m_engineOptions = options;
+
+    // tesseract requires the "C" locale while initializing
+    char *old_ctype = strdup(setlocale(LC_ALL, NULL));
+    setlocale(LC_ALL, "C");
+    bool ok = m_recognizer.init(dataPath, language, profile.engineMode);
+    if (ok && parallel) {
+        ok = m_parallelRecognizer.init(dataPath, language, profile.engineMode);
+    }
+    setlocale(LC_ALL, old_ctype);
+    free(old_ctype);
+
+    const int areaMode = profile.areaPageSegModeFor(options.detector.grouping);
+    m_recognizer.setPageSegModes(profile.pageSegMode, areaMode);
+    m_parallelRecognizer.setPageSegModes(profile.pageSegMode, areaMode);
+    return ok;
+}
+
+/**
+ * Runs one OCR job: optional text area detection followed by recognition
+ * The time per stage is reported when the job is done.
+ *
+ * @param image to perform OCR on
+ * @param options of the job
+ */
+void OcrWorker::process(SharedImage image, OcrOptions options)
+{
+    Tracer::instance().setThreadName("ocr worker");
+    const int64_t start = Tracer::instance().now();
+    {
+        TraceSpan span("ocr_job");
+        run(image, options);
+    }
+    emit stagesTimed(QString::fromStdString(Tracer::instance().breakdownText(start)));
+}
+
+/**
+ * Performs one OCR job, every stage is recorded as trace span
+ *
+ * @param image to perform OCR on
+ * @param options of the job
+ */
+void OcrWorker::run(const SharedImage &image, const OcrOptions &options)
+{
+    startJob();
+    if (isCancelled()) {
+        emit finished(true, "");
+        return;
+    }
+
+    // identical pixels and settings give the same result
+    QByteArray key;
+    {
+        TraceSpan span("cache_lookup");
+        key = ResultCache::key(image, options.detectAreas, options.detector, options.preprocess,
+            m_language, QString::fromStdString(options.profile.name));
+        if (answerFromCache(key, options)) {
+            return;
+        }
+    }
+
+    emit stageChanged("Initializing OCR", 0);
+    {
+        TraceSpan span("init_engines");
+        if (!initEngines(options, false)) {
+            emit failed("Failed to initialize tesseract.");
+            return;
+        }
+    }
+
+    // the frame shares the buffer of the image, which lives until the job is done
+    cv::Mat frame = image.mat();
+    cv::Mat detectionFrame = frame;
+    PreprocessedFrame preprocessed;
+    if (options.preprocess.enabled) {
+        // detection on the grayscale, recognition on the binarized frame (both deskewed)
+        emit stageChanged("Preprocessing", 0);
+        TraceSpan span("preprocess");
+        preprocessed = Preprocessor::process(frame, options.preprocess);
+        detectionFrame = preprocessed.gray;
+        frame = preprocessed.binary;
+    }
+    {
+        TraceSpan span("set_image");
+        m_recognizer.setImage(frame);
+    }
+
+    QString summary;
+    CachedResult result;
+    TextPage page;
+    page.size = cv::Size(image.width(), image.height());
+    if (options.detectAreas) {
+        emit stageChanged("Detecting text areas", 0);
+        m_detector.setSettings(options.detector);
+        std::vector<cv::Rect> areas;
+        bool loaded;
+        {
+            TraceSpan span("detect");
+            loaded = m_detector.detect(detectionFrame, areas);
+        }
+        if (!loaded) {
+            emit failed("Failed to load the EAST model.");
+            return;
+        }
+        if (isCancelled()) {
+            emit finished(true, "");
+            return;
+        }
+        const size_t boxCount = areas.size();
+        {
+            TraceSpan span("group");
+            areas = TextGrouper::group(areas, (TextGrouper::Mode)options.detector.grouping);
+        }
+
+        // the areas are shown on the original image
+        const cv::Rect bounds(0, 0, image.width(), image.height());
+        for (const cv::Rect &area : areas) {
+            cv::Rect shown = Preprocessor::mapToSource(area, preprocessed) & bounds;
+            result.areas << QRect(shown.x, shown.y, shown.width, shown.height);
+        }
+        emit areasDetected(result.areas);
+
+        QElapsedTimer timer;
+        timer.start();
+        int engines = 1;
+        if (!recognizeAreas(frame, areas, engines, result.texts, true, &page.blocks)) {
+            emit finished(true, "");
+            return;
+        }
+        summary = QString("forward %1 ms, %2 boxes grouped into %3 areas (%4 calls saved), recognized by %5 engines in %6 ms")
+            .arg(m_detector.lastForwardMs(), 0, 'f', 1).arg(boxCount).arg(areas.size())
+            .arg(boxCount - areas.size()).arg(engines).arg(timer.elapsed());
+        if (preprocessed.angle != 0.0) {
+            summary += QString(", deskewed by %1 degrees").arg(preprocessed.angle, 0, 'f', 1);
+        }
+    } else {
+        m_stage = "Recognizing text";
+        m_lastPercent = -1;
+        std::string text;
+        {
+            TraceSpan span("recognize");
+            text = m_recognizer.recognize();
+        }
+        if (m_recognizer.wasCancelled()) {
+            emit finished(true, "");
+            return;
+        }
+        result.texts << QString::fromStdString(text);
+        emit textRecognized(0, result.texts.last());
+        m_recognizer.readLayout(page.blocks);
+    }
+
+    // the boxes are reported on the original image
+    if (options.preprocess.enabled) {
+        const cv::Rect bounds(cv::Point(0, 0), page.size);
+        mapTextBoxes(page.blocks, [&preprocessed, &bounds](const cv::Rect &box) {
+            return Preprocessor::mapToSource(box, preprocessed) & bounds;
+        });
+    }
+    emit layoutRecognized(page);
+
+    // only complete results are cached
+    {
+        TraceSpan span("cache_store");
+        m_cache.store(key, result);
+    }
+    emit cacheStatsChanged(m_cache.hits(), m_cache.misses());
+    emit finished(false, summary);
+}
+
+/**
+ * Streams the cached result of a job, if there is one
+ *
+ * @param key of the job
+ * @param options of the job
+ * @returns true if the job was answered from the cache
+ */
+bool OcrWorker::answerFromCache(const QByteArray &key, const OcrOptions &options)
+{
+    CachedResult result;
+    bool hit = m_cache.lookup(key, result);
+    emit cacheStatsChanged(m_cache.hits(), m_cache.misses());
+    if (!hit) {
+        return false;
+    }
+
+    if (options.detectAreas) {
+        emit areasDetected(result.areas);
+    }
+    for (int i = 0; i < result.texts.size(); ++i) {
+        emit textRecognized(i, result.texts[i]);
+    }
+    emit finished(false, QString("cached result (%1 areas)").arg(result.areas.size()));
+    return true;
+}
+
+/**
+ * Loads the engines of a profile ahead of the first job
+ * Errors are not reported as failure, the first job reports them again.
+ *
+ * @param options the engines are loaded for
+ */
+void OcrWorker::preload(OcrOptions options)
+{
+    Tracer::instance().setThreadName("ocr worker");
+    TraceSpan span("preload");
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok = initEngines(options, false);
+    m_detector.setSettings(options.detector);
+    ok = m_detector.load() && ok;
+
+    if (ok) {
+        emit preloaded(QString("Models loaded in %1 ms (%2 MB mapped)").arg(timer.elapsed())
+            .arg(ModelStore::instance().mappedBytes() / (1024.0 * 1024.0), 0, 'f', 1));
+    } else {
+        emit preloaded("Models could not be preloaded");
+    }
+}
+
+/**
+ * Runs OCR on all pages of a multi-page document (TIFF or PDF)
+ * The pages are processed as pipeline: a decoder thread decodes and detects
+ * page N+1 while page N is recognized. At most PIPELINE_DEPTH decoded pages
+ * wait in between, so the memory does not depend on the number of pages.
+ *
+ * @param path of the document
+ * @param options of the job
+ */
+void OcrWorker::processDocument(QString path, OcrOptions options)
+{
+    Tracer::instance().setThreadName("ocr worker");
+    TraceSpan jobSpan("document_job");
+    startJob();
+    if (isCancelled()) {
+        emit finished(true, "");
+        return;
+    }
+
+    emit stageChanged("Initializing OCR", 0);
+    if (!initEngines(options, false)) {
+        emit failed("Failed to initialize tesseract.");
+        return;
+    }
+
+    struct Page {
+        int index;
+        SharedImage image;
+        PreprocessedFrame preprocessed;
+        cv::Mat frame;                  // input of the recognition (view of image or preprocessed)
+        std::vector<cv::Rect> areas;
+    };
+    BoundedQueue<Page> queue(PIPELINE_DEPTH);
+    std::atomic<int> pageCount(0);
+    std::atomic<bool> readFailed(false);
+    std::atomic<bool> modelFailed(false);
+
+    // the detector is used by the decoder thread only while the document is processed
+    m_detector.setSettings(options.detector);
+    std::thread decoder([&]() {
+        Tracer::instance().setThreadName("page decoder");
+        DocumentReader reader;
+        if (!reader.open(path)) {
+            readFailed = true;
+            queue.close();
+            return;
+        }
+        pageCount = reader.pageCount();
+        for (int i = 0; i < reader.pageCount() && !isCancelled(); ++i) {
+            Page page;
+            page.index = i;
+            {
+                TraceSpan span("decode_page", i);
+                page.image = reader.page(i);
+            }
+            if (page.image.isNull()) {
+                readFailed = true;
+                break;
+            }
+            page.frame = page.image.mat();
+            cv::Mat detectionFrame = page.frame;
+            if (options.preprocess.enabled) {
+                TraceSpan span("preprocess", i);
+                page.preprocessed = Preprocessor::process(page.frame, options.preprocess);
+                detectionFrame = page.preprocessed.gray;
+                page.frame = page.preprocessed.binary;
+            }
+            if (options.detectAreas) {
+                TraceSpan span("detect", i);
+                if (!m_detector.detect(detectionFrame, page.areas)) {
+                    modelFailed = true;
+                    break;
+                }
+                page.areas = TextGrouper::group(page.areas, (TextGrouper::Mode)options.detector.grouping);
+            }
+            // waits while the recognition is PIPELINE_DEPTH pages behind
+            if (!queue.push(std::move(page))) {
+                break;
+            }
+        }
+        queue.close();
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    int pages = 0;
+    Page page;
+    while (queue.pop(page)) {
+        m_stage = QString("Recognizing page %1/%2").arg(page.index + 1).arg(pageCount.load());
+        m_lastPercent = -1;
+        emit stageChanged(m_stage, 0);
+
+        cv::Mat frame = page.frame;
+        m_recognizer.setImage(frame);
+        QStringList texts;
+        TextPage layout;
+        layout.index = page.index;
+        layout.size = cv::Size(page.image.width(), page.image.height());
+        bool complete = true;
+        if (options.detectAreas) {
+            int engines = 1;
+            complete = recognizeAreas(frame, page.areas, engines, texts, false, &layout.blocks);
+        } else {
+            TraceSpan span("recognize", page.index);
+            texts << QString::fromStdString(m_recognizer.recognize());
+            complete = !m_recognizer.wasCancelled();
+            m_recognizer.readLayout(layout.blocks);
+        }
+        if (!complete || isCancelled()) {
+            break;
+        }
+        if (page.index == 0 && options.detectAreas) {
+            // only the first page is shown
+            QVector<QRect> rects;
+            const cv::Rect bounds(0, 0, page.image.width(), page.image.height());
+            for (const cv::Rect &area : page.areas) {
+                cv::Rect shown = Preprocessor::mapToSource(area, page.preprocessed) & bounds;
+                rects << QRect(shown.x, shown.y, shown.width, shown.height);
+            }
+            emit areasDetected(rects);
+        }
+        const cv::Rect bounds(cv::Point(0, 0), layout.size);
+        mapTextBoxes(layout.blocks, [&page, &bounds](const cv::Rect &box) {
+            return Preprocessor::mapToSource(box, page.preprocessed) & bounds;
+        });
+        emit layoutRecognized(layout);
+        emit textRecognized(page.index, QString("=== Page %1 ===\n").arg(page.index + 1) + texts.join(""));
+        ++pages;
+    }
+
+    // stops the decoder if the recognition ended early
+    queue.close();
+    decoder.join();
+
+    if (readFailed) {
+        emit failed(QString("Can't read page %1 of %2.").arg(pages + 1).arg(path));
+    } else if (modelFailed) {
+        emit failed("Failed to load the EAST model.");
+    } else {
+        emit finished(isCancelled(), QString("%1 pages in %2 ms").arg(pages).arg(timer.elapsed()));
+    }
+}
+
+/**
+ * Runs OCR on the changed parts of a watched region
+ * Within every dirty rectangle text areas are detected (if requested) and
+ * recognized, the rest of the frame is not touched. Screen content is
+ * neither skewed nor noisy, so no preprocessing is done.
+ *
+ * @param frame latest grab of the watched region
+ * @param dirty changed rectangles in frame coordinates
+ * @param options of the job
+ */
+void OcrWorker::processRegions(SharedImage frame, QVector<QRect> dirty, OcrOptions options)
+{
+    Tracer::instance().setThreadName("ocr worker");
+    TraceSpan span("watch_job");
+    startJob();
+    if (isCancelled()) {
+        return;     // the watch was stopped while the job was queued
+    }
+
+    if (!initEngines(options, false)) {
+        emit failed("Failed to initialize tesseract.");
+        return;
+    }
+
+    cv::Mat image = frame.mat();
+    m_recognizer.setImage(image);
+    m_detector.setSettings(options.detector);
+
+    std::vector<cv::Rect> areas;
+    for (const QRect &rect : dirty) {
+        cv::Rect bounds = cv::Rect(rect.x(), rect.y(), rect.width(), rect.height()) & cv::Rect(0, 0, image.cols, image.rows);
+        if (bounds.empty()) {
+            continue;
+        }
+        if (!options.detectAreas) {
+            areas.push_back(bounds);
+            continue;
+        }
+        // detection on the crop only, the areas are moved into frame coordinates
+        std::vector<cv::Rect> found;
+        if (!m_detector.detect(image(bounds), found)) {
+            emit failed("Failed to load the EAST model.");
+            return;
+        }
+        for (const cv::Rect &area : TextGrouper::group(found, (TextGrouper::Mode)options.detector.grouping)) {
+            areas.push_back((area + bounds.tl()) & bounds);
+        }
+    }
+
+    QStringList texts;
+    int engines = 1;
+    if (!recognizeAreas(image, areas, engines, texts, false) || isCancelled()) {
+        return;
+    }
+
+    QVector<QRect> rects;
+    for (const cv::Rect &area : areas) {
+        rects << QRect(area.x, area.y, area.width, area.height);
+    }
+    emit regionsRecognized(dirty, rects, texts);
+}
+
+/**
+ * Recognizes the detected areas and streams the text back in area order
+ * Many areas are spread over several Tesseract instances.
+ *
+ * @param frame containing the areas
+ * @param areas to be recognized
+ * @param engines number of Tesseract instances used
+ * @param texts recognized text per area
+ * @param stream emit textRecognized() for every area
+ * @param blocks receiving the word boxes of all areas in frame coordinates (optional)
+ * @returns false if the job was cancelled
+ */
+bool OcrWorker::recognizeAreas(const cv::Mat &frame, const std::vector<cv::Rect> &areas, int &engines,
+    QStringList &texts, bool stream, std::vector<TextBlock> *blocks)
+{
+    const int count = (int)areas.size();
+
+    // only worth the extra instances for many areas
+    engines = m_parallelRecognizer.threadsFor(areas.size());
+    if (engines > 1 && initEngines(m_engineOptions, true)) {
+        bool complete = m_parallelRecognizer.recognize(frame, areas, [this, count, &texts, stream](int index, const std::string &text) {
+            emit stageChanged(QString("Recognizing area %1/%2").arg(index + 1).arg(count), 100);
+            texts << QString::fromStdString(text);
+            if (stream) {
+                emit textRecognized(index, texts.last());
+            }
+            return !isCancelled();
+        }, engines);
+        for (int i = 0; complete && blocks != nullptr && i < count; ++i) {
+            const std::vector<TextBlock> &area = m_parallelRecognizer.blocks(i);
+            blocks->insert(blocks->end(), area.begin(), area.end());
+        }
+        return complete;
+    }
+
+    engines = 1;
+    for (int i = 0; i < count; ++i) {
+        m_stage = QString("Recognizing area %1/%2").arg(i + 1).arg(count);
+        m_lastPercent = -1;
+        std::string text;
+        {
+            TraceSpan span("recognize_area", i);
+            text = m_recognizer.recognize(areas[i]);
+        }
+        if (m_recognizer.wasCancelled() || isCancelled()) {
+            return false;
+        }
+        if (blocks != nullptr) {
+            m_recognizer.readLayout(*blocks, i);
+        }
+        texts << QString::fromStdString(text);
+        if (stream) {
+            emit textRecognized(i, texts.last());
+        }
+    }
+    return true;
+}
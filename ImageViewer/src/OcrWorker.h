@@ -0,0 +1,117 @@
+/**
+ * @file OcrWorker.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef OCRWORKER_H
+#define OCRWORKER_H
+
+// system includes
+#include <QObject>
+#include <QRect>
+#include <QVector>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+
+// local includes
+#include "TextDetector.h"
+#include "TextRecognizer.h"
+#include "Preprocessor.h"
+#include "OcrProfile.h"
+#include "ParallelRecognizer.h"
+#include "SharedImage.h"
+#include "ResultCache.h"
+#include "TextLayout.h"
+
+/**
+ * Options of one OCR job
+ */
+struct OcrOptions
+{
+    bool detectAreas = false;   // detect text areas prior OCR
+    DetectorSettings detector;
+    PreprocessSettings preprocess;
+    OcrProfile profile;         // engine configuration (detector and preprocess are already applied)
+};
+
+Q_DECLARE_METATYPE(OcrOptions)
+Q_DECLARE_METATYPE(TextPage)
+
+/**
+ * Asynchronous OCR job engine
+ *
+ * OcrWorker owns the text detector and the Tesseract API and is meant to
+ * live in its own thread, so the GUI stays responsive while text areas are
+ * detected and recognized. Jobs are started through the process() slot
+ * (queued connection), results are streamed back area by area through
+ * signals. Every job has to be announced with jobQueued() when it is
+ * queued; cancel() (from any thread) then stops the running job and every
+ * job queued so far, also those which did not start yet. It is forwarded
+ * to Tesseract's progress monitor. Documents with many
+ * text areas are recognized by a pool of Tesseract instances in parallel.
+ * Results of completed jobs are kept in a ResultCache, a repeated job on
+ * identical pixels and settings is answered from the cache.
+ * In watch mode only the changed rectangles of a frame are processed
+ * (processRegions()). Multi-page documents are decoded page by page in a
+ * pipeline (processDocument()). Next to the text, the words, lines and
+ * blocks with boxes and confidences are read from the same recognition and
+ * reported per page (not for results answered from the cache).
+ */
+class OcrWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OcrWorker(QObject *parent=nullptr);
+    ~OcrWorker();
+
+    void jobQueued();           // thread safe, call whenever a job is queued (process, processRegions, processDocument)
+    void cancel();              // thread safe, cancels the running job and all queued ones
+
+public slots:
+    void process(SharedImage image, OcrOptions options);
+    void processRegions(SharedImage frame, QVector<QRect> dirty, OcrOptions options);
+    void processDocument(QString path, OcrOptions options);
+    void preload(OcrOptions options);
+
+signals:
+    void stageChanged(QString stage, int percent);      // progress of the running job
+    void areasDetected(QVector<QRect> areas);           // detected text areas in image coordinates
+    void textRecognized(int index, QString text);       // text of one area (index 0 for whole image)
+    void finished(bool cancelled, QString summary);
+    void failed(QString message);
+    void cacheStatsChanged(int hits, int misses);       // statistics of the result cache
+    void stagesTimed(QString breakdown);                // time per stage of the last job (trace spans)
+    void regionsRecognized(QVector<QRect> dirty, QVector<QRect> areas, QStringList texts);  // result of processRegions()
+    void preloaded(QString summary);                    // engines are ready (or failed to load)
+    void layoutRecognized(TextPage page);               // word boxes of one page in image coordinates
+
+private:
+    void run(const SharedImage &image, const OcrOptions &options);
+    bool initEngines(const OcrOptions &options, bool parallel);
+    bool recognizeAreas(const cv::Mat &frame, const std::vector<cv::Rect> &areas, int &engines,
+        QStringList &texts, bool stream = true, std::vector<TextBlock> *blocks = nullptr);
+    bool answerFromCache(const QByteArray &key, const OcrOptions &options);
+    void startJob();
+    bool isCancelled() const { return m_job.load() <= m_cancelledJobs.load(); }
+
+private:
+    static const int PIPELINE_DEPTH = 2;        // decoded pages waiting for recognition
+
+    TextDetector m_detector;
+    TextRecognizer m_recognizer;
+    ParallelRecognizer m_parallelRecognizer;    // pool of instances for documents with many areas
+    ResultCache m_cache;        // results of previous jobs (on disk)
+    const QString m_language;   // language of the recognition
+    std::atomic<quint64> m_queuedJobs;     // jobs announced by jobQueued()
+    std::atomic<quint64> m_cancelledJobs;  // jobs up to this number are cancelled
+    std::atomic<quint64> m_job;            // number of the running job (jobs run in queue order)
+    QString m_stage;            // stage reported together with tesseract's progress
+    int m_lastPercent;
+    OcrOptions m_engineOptions; // options the engines were last initialized for
+};
+
+#endif // OCRWORKER_H
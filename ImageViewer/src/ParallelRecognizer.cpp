@@ -0,0 +1,201 @@
+// system includes
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// local includes
+#include "ParallelRecognizer.h"
+#include "Tracer.h"
+
+ParallelRecognizer::ParallelRecognizer(int threads) : m_threads(std::max(1, threads)),
+    m_minAreasPerThread(4), m_cancelled(false), m_stopped(false)
+{
+}
+
+ParallelRecognizer::~ParallelRecognizer()
+{
+}
+
+/**
+ * Initializes all Tesseract instances of the pool, again only if the configuration changed
+ * Tesseract requires the "C" locale while initializing.
+ *
+ * @param dataPath to the pretrained tessdata directory
+ * @param language of the pretrained data
+ * @param engineMode tesseract::OcrEngineMode
+ * @returns false if an instance could not be initialized
+ */
+bool ParallelRecognizer::init(const std::string &dataPath, const std::string &language, int engineMode)
+{
+    if (isInitialized()) {
+        // the instances keep the configuration if it did not change
+        for (std::unique_ptr<TextRecognizer> &recognizer : m_recognizers) {
+            if (!recognizer->init(dataPath, language, engineMode)) {
+                m_recognizers.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<std::unique_ptr<TextRecognizer>> recognizers;
+    for (int i = 0; i < m_threads; ++i) {
+        std::unique_ptr<TextRecognizer> recognizer(new TextRecognizer());
+        if (!recognizer->init(dataPath, language, engineMode)) {
+            return false;
+        }
+        // stop all instances as soon as one result is rejected
+        recognizer->setMonitor([this](int) { return !isStopped(); });
+        recognizers.push_back(std::move(recognizer));
+    }
+    m_recognizers = std::move(recognizers);
+    return true;
+}
+
+/**
+ * Sets the page segmentation modes of all instances
+ *
+ * @param pageMode tesseract::PageSegMode of whole images
+ * @param areaMode tesseract::PageSegMode of the areas
+ */
+void ParallelRecognizer::setPageSegModes(int pageMode, int areaMode)
+{
+    for (std::unique_ptr<TextRecognizer> &recognizer : m_recognizers) {
+        recognizer->setPageSegModes(pageMode, areaMode);
+    }
+}
+
+/**
+ * Requests the running recognition to stop as soon as possible (thread safe)
+ * A request arriving before recognize() is called cancels that recognition,
+ * it stays in effect until resetCancel().
+ */
+void ParallelRecognizer::cancel()
+{
+    m_cancelled = true;
+}
+
+/**
+ * Clears a cancel request, to be called by the owner before a new job (thread safe)
+ */
+void ParallelRecognizer::resetCancel()
+{
+    m_cancelled = false;
+}
+
+/**
+ * Number of instances worth using for a given number of areas
+ *
+ * @param areaCount number of areas to be recognized
+ * @returns number of instances (at least 1)
+ */
+int ParallelRecognizer::threadsFor(size_t areaCount) const
+{
+    size_t worth = areaCount / std::max(1, m_minAreasPerThread);
+    return (int)std::max<size_t>(1, std::min<size_t>(m_threads, worth));
+}
+
+/**
+ * Recognizes the areas of an image, results are passed in area order
+ * The callback is called from the calling thread.
+ *
+ * @param image with 8 bit depth and 1 or 3 channels
+ * @param areas in image coordinates
+ * @param callback receiving index and text of every area, returns false to cancel
+ * @param threads number of instances to use (0: decided by the number of areas)
+ * @returns false if the recognition was cancelled
+ */
+bool ParallelRecognizer::recognize(const cv::Mat &image, const std::vector<cv::Rect> &areas,
+    const ResultCallback &callback, int threads)
+{
+    CV_Assert(isInitialized());
+
+    const int count = (int)areas.size();
+    threads = threads > 0 ? std::min(threads, m_threads) : threadsFor(areas.size());
+    m_stopped = false;
+    m_blocks.assign(count, std::vector<TextBlock>());
+
+    // a single instance passes every result on directly
+    if (threads == 1) {
+        TextRecognizer &recognizer = *m_recognizers[0];
+        for (int i = 0; i < count && !isStopped(); ++i) {
+            std::string text = recognizeCrop(recognizer, image, areas[i], i, m_blocks[i]);
+            if (isStopped() || !callback(i, text)) {
+                m_stopped = true;
+            }
+        }
+        return !isStopped();
+    }
+
+    std::vector<std::string> texts(count);
+    std::vector<char> done(count, 0);
+    std::atomic<int> next(0);                       // index of the next area to be recognized
+    std::mutex mutex;
+    std::condition_variable resultReady;
+
+    // every instance pulls the next area and recognizes its crop
+    auto work = [&](TextRecognizer &recognizer) {
+        for (int i = next++; i < count && !isStopped(); i = next++) {
+            // every area has its own slot, written by exactly one instance
+            std::string text = recognizeCrop(recognizer, image, areas[i], i, m_blocks[i]);
+            std::lock_guard<std::mutex> lock(mutex);
+            texts[i] = std::move(text);
+            done[i] = 1;
+            resultReady.notify_one();
+        }
+        // wake up the waiting caller in case of cancellation
+        std::lock_guard<std::mutex> lock(mutex);
+        resultReady.notify_all();
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back(work, std::ref(*m_recognizers[t]));
+    }
+
+    // hand the results over in the order of the areas
+    for (int i = 0; i < count; ++i) {
+        std::unique_lock<std::mutex> lock(mutex);
+        resultReady.wait(lock, [&]() { return done[i] != 0 || isStopped(); });
+        if (isStopped()) {
+            break;
+        }
+        std::string text = std::move(texts[i]);
+        lock.unlock();
+        if (!callback(i, text)) {
+            m_stopped = true;
+        }
+    }
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    return !isStopped();
+}
+
+/**
+ * Recognizes a single area on its own crop of the image
+ * The crop is a view of the shared image, Tesseract copies it into its own Pix in SetImage().
+ *
+ * @param recognizer instance to be used
+ * @param image containing the area
+ * @param area in image coordinates
+ * @param index of the area (shown in the trace)
+ * @param blocks receiving the layout of the area in image coordinates
+ * @returns recognized text
+ */
+std::string ParallelRecognizer::recognizeCrop(TextRecognizer &recognizer, const cv::Mat &image,
+    const cv::Rect &area, int index, std::vector<TextBlock> &blocks)
+{
+    TraceSpan span("recognize_area", index);
+    cv::Rect crop = area & cv::Rect(0, 0, image.cols, image.rows);
+    if (crop.empty()) {
+        return "";
+    }
+    recognizer.setImage(image(crop));
+    // the whole crop is one area (page segmentation mode of areas)
+    std::string text = recognizer.recognize(cv::Rect(0, 0, crop.width, crop.height));
+    recognizer.readLayout(blocks, index, crop.tl());
+    return text;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file ParallelRecognizer.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef PARALLELRECOGNIZER_H
+#define PARALLELRECOGNIZER_H
+
+// system includes
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// local includes
+#include "TextRecognizer.h"
+
+/**
+ * Recognition of many text areas spread over several Tesseract instances
+ *
+ * ParallelRecognizer owns a pool of TextRecognizer instances. The areas of
+ * one image are distributed over the instances, every instance works on its
+ * own crop of the (shared, read only) image. The results are handed back in
+ * the order of the areas. Only as many instances are used as it is worth for
+ * the number of areas, small jobs are recognized by a single instance.
+ * The word boxes of every area are kept until the next recognition.
+ */
+class ParallelRecognizer
+{
+public:
+    typedef std::function<bool(int, const std::string&)> ResultCallback;  // returns false to cancel
+
+    explicit ParallelRecognizer(int threads = 1);
+    ~ParallelRecognizer();
+
+    bool init(const std::string &dataPath = TESSDATA_PATH, const std::string &language = "eng",
+        int engineMode = tesseract::OEM_DEFAULT);
+    bool isInitialized() const { return !m_recognizers.empty(); }
+    void setPageSegModes(int pageMode, int areaMode);
+
+    int threads() const { return m_threads; }
+    void setMinAreasPerThread(int count) { m_minAreasPerThread = count; }
+    int threadsFor(size_t areaCount) const;
+
+    bool recognize(const cv::Mat &image, const std::vector<cv::Rect> &areas,
+        const ResultCallback &callback, int threads = 0);
+    void cancel();                  // thread safe, cancels the running or next recognition
+    void resetCancel();             // thread safe, clears the cancel request for a new job
+    const std::vector<TextBlock> &blocks(int index) const { return m_blocks[index]; }   // layout of an area (page coordinates)
+
+private:
+    ParallelRecognizer(const ParallelRecognizer &) = delete;
+    ParallelRecognizer &operator=(const ParallelRecognizer &) = delete;
+
+    static std::string recognizeCrop(TextRecognizer &recognizer, const cv::Mat &image,
+        const cv::Rect &area, int index, std::vector<TextBlock> &blocks);
+    bool isStopped() const { return m_stopped.load() || m_cancelled.load(); }
+
+    int m_threads;                  // maximal number of instances
+    int m_minAreasPerThread;        // an extra instance is only used for that many areas
+    std::vector<std::unique_ptr<TextRecognizer>> m_recognizers;
+    std::vector<std::vector<TextBlock>> m_blocks;   // layout per area of the last recognition
+    std::atomic<bool> m_cancelled;  // requested by the owner, kept until resetCancel()
+    std::atomic<bool> m_stopped;    // the running recognition was stopped (rejected result)
+};
+
+#endif // PARALLELRECOGNIZER_H
@@ -0,0 +1,258 @@
+// system includes
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PREPROCESSOR_SSE2
+#endif
+
+// local includes
+#include "Preprocessor.h"
+#include "Tracer.h"
+
+/**
+ * Runs the enabled steps: grayscale, deskew and binarization
+ *
+ * @param rgb frame (8 bit, 3 channels)
+ * @param settings of the preprocessing
+ * @returns grayscale and binarized frame, the buffers are owned by the result
+ */
+PreprocessedFrame Preprocessor::process(const cv::Mat &rgb, const PreprocessSettings &settings)
+{
+    PreprocessedFrame frame;
+    cv::Mat source = rgb;
+    double scale = 1.0;
+    if (settings.maxSide > 0 && std::max(rgb.cols, rgb.rows) > settings.maxSide) {
+        TraceSpan span("downscale");
+        scale = (double)settings.maxSide / std::max(rgb.cols, rgb.rows);
+        cv::resize(rgb, source, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+    {
+        TraceSpan span("grayscale");
+        grayscale(source, frame.gray);
+    }
+
+    if (settings.deskew) {
+        TraceSpan span("deskew");
+        frame.angle = estimateSkew(frame.gray, settings.maxSkew);
+        if (std::abs(frame.angle) >= 0.1) {
+            // the canvas grows, so no corner of the frame is cut off
+            const double radians = frame.angle * CV_PI / 180.0;
+            const double c = std::abs(std::cos(radians));
+            const double s = std::abs(std::sin(radians));
+            const cv::Size size(cvCeil(frame.gray.cols * c + frame.gray.rows * s),
+                cvCeil(frame.gray.cols * s + frame.gray.rows * c));
+            cv::Mat rotation = cv::getRotationMatrix2D(
+                cv::Point2f(frame.gray.cols / 2.0f, frame.gray.rows / 2.0f), frame.angle, 1.0);
+            rotation.at<double>(0, 2) += (size.width - frame.gray.cols) / 2.0;
+            rotation.at<double>(1, 2) += (size.height - frame.gray.rows) / 2.0;
+
+            cv::Mat rotated;
+            cv::warpAffine(frame.gray, rotated, rotation, size, cv::INTER_LINEAR,
+                cv::BORDER_CONSTANT, cv::Scalar(255));
+            frame.gray = rotated;
+            cv::invertAffineTransform(rotation, frame.toSource);
+        } else {
+            frame.angle = 0.0;
+        }
+    }
+    if (scale != 1.0) {
+        // the scaling is undone after the rotation (uniform, so all coefficients are divided)
+        if (frame.toSource.empty()) {
+            frame.toSource = (cv::Mat_<double>(2, 3) << 1.0, 0.0, 0.0, 0.0, 1.0, 0.0);
+        }
+        frame.toSource /= scale;
+    }
+
+    if (settings.binarize) {
+        TraceSpan span("binarize");
+        binarize(frame.gray, frame.binary, settings.blockSize, settings.offset);
+    } else {
+        frame.binary = frame.gray;
+    }
+    return frame;
+}
+
+/**
+ * Converts RGB to grayscale with the weights of ITU-R BT.601 in 8 bit fixed point
+ * 16 pixels are converted at once with SSE2, the result equals grayscaleScalar().
+ *
+ * @param rgb frame (8 bit, 3 channels, R first)
+ * @param gray result (8 bit, 1 channel)
+ */
+void Preprocessor::grayscale(const cv::Mat &rgb, cv::Mat &gray)
+{
+    CV_Assert(rgb.type() == CV_8UC3);
+    gray.create(rgb.size(), CV_8UC1);
+
+    for (int y = 0; y < rgb.rows; ++y) {
+        const uchar *src = rgb.ptr<uchar>(y);
+        uchar *dst = gray.ptr<uchar>(y);
+        int x = 0;
+#ifdef PREPROCESSOR_SSE2
+        // the products are at most 255 * 150 and the sum at most 255 * 256 + 128, all fit into 16 bit
+        const __m128i vr = _mm_set1_epi16(GRAY_R), vg = _mm_set1_epi16(GRAY_G), vb = _mm_set1_epi16(GRAY_B);
+        const __m128i half = _mm_set1_epi16(128);
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= rgb.cols; x += 16) {
+            // deinterleaves 48 bytes into 16 r, g and b values by repeated unpacking
+            const __m128i *p = (const __m128i *)(src + 3 * x);
+            __m128i t00 = _mm_loadu_si128(p), t01 = _mm_loadu_si128(p + 1), t02 = _mm_loadu_si128(p + 2);
+            __m128i t10 = _mm_unpacklo_epi8(t00, _mm_unpackhi_epi64(t01, t01));
+            __m128i t11 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t00, t00), t02);
+            __m128i t12 = _mm_unpacklo_epi8(t01, _mm_unpackhi_epi64(t02, t02));
+            __m128i t20 = _mm_unpacklo_epi8(t10, _mm_unpackhi_epi64(t11, t11));
+            __m128i t21 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t10, t10), t12);
+            __m128i t22 = _mm_unpacklo_epi8(t11, _mm_unpackhi_epi64(t12, t12));
+            __m128i t30 = _mm_unpacklo_epi8(t20, _mm_unpackhi_epi64(t21, t21));
+            __m128i t31 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t20, t20), t22);
+            __m128i t32 = _mm_unpacklo_epi8(t21, _mm_unpackhi_epi64(t22, t22));
+            const __m128i r = _mm_unpacklo_epi8(t30, _mm_unpackhi_epi64(t31, t31));
+            const __m128i g = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t30, t30), t32);
+            const __m128i b = _mm_unpacklo_epi8(t31, _mm_unpackhi_epi64(t32, t32));
+
+            __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(r, zero), vr),
+                _mm_mullo_epi16(_mm_unpacklo_epi8(g, zero), vg)),
+                _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), vb), half));
+            __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(r, zero), vr),
+                _mm_mullo_epi16(_mm_unpackhi_epi8(g, zero), vg)),
+                _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), vb), half));
+            _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+        }
+#endif
+        for (; x < rgb.cols; ++x) {
+            const uchar *p = src + 3 * x;
+            dst[x] = (uchar)((p[0] * GRAY_R + p[1] * GRAY_G + p[2] * GRAY_B + 128) >> 8);
+        }
+    }
+}
+
+/**
+ * Scalar reference of grayscale(), used to check the SSE2 path
+ *
+ * @param rgb frame (8 bit, 3 channels, R first)
+ * @param gray result (8 bit, 1 channel)
+ */
+void Preprocessor::grayscaleScalar(const cv::Mat &rgb, cv::Mat &gray)
+{
+    CV_Assert(rgb.type() == CV_8UC3);
+    gray.create(rgb.size(), CV_8UC1);
+
+    for (int y = 0; y < rgb.rows; ++y) {
+        const uchar *src = rgb.ptr<uchar>(y);
+        uchar *dst = gray.ptr<uchar>(y);
+        for (int x = 0; x < rgb.cols; ++x) {
+            const uchar *p = src + 3 * x;
+            dst[x] = (uchar)((p[0] * GRAY_R + p[1] * GRAY_G + p[2] * GRAY_B + 128) >> 8);
+        }
+    }
+}
+
+/**
+ * Adaptive threshold against the mean of the neighbourhood
+ * Unlike a global threshold this copes with shadows and uneven lighting.
+ *
+ * @param gray frame (8 bit, 1 channel)
+ * @param binary result, text 0 and background 255
+ * @param blockSize of the neighbourhood (made odd)
+ * @param offset below the mean
+ */
+void Preprocessor::binarize(const cv::Mat &gray, cv::Mat &binary, int blockSize, int offset)
+{
+    blockSize = std::max(3, blockSize | 1);
+    cv::adaptiveThreshold(gray, binary, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY, blockSize, offset);
+}
+
+/**
+ * Estimates the skew of the text lines
+ * The text pixels of a downscaled copy are projected onto the vertical axis
+ * at different angles, text lines are horizontal where the profile is most
+ * peaked. Searched in steps of 1 degree, then 0.1 degree around the best.
+ *
+ * @param gray frame (8 bit, 1 channel)
+ * @param maxDegrees largest angle searched in both directions
+ * @returns angle of the text lines in degrees (positive if falling to the right, 0 if no text was found)
+ */
+double Preprocessor::estimateSkew(const cv::Mat &gray, double maxDegrees)
+{
+    const int maxSide = 800;
+    const double scale = std::min(1.0, (double)maxSide / std::max(gray.cols, gray.rows));
+    cv::Mat small = gray;
+    if (scale < 1.0) {
+        cv::resize(gray, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+
+    // text pixels are the dark ones
+    cv::Mat text;
+    cv::adaptiveThreshold(small, text, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY_INV, 15, 15);
+    std::vector<cv::Point> points;
+    cv::findNonZero(text, points);
+    if (points.size() < 100) {
+        return 0.0;
+    }
+
+    const int bins = small.cols + small.rows;
+    double best = 0.0;
+    double bestScore = profileScore(points, 0.0, bins);
+    for (double degrees = -maxDegrees; degrees <= maxDegrees; degrees += 1.0) {
+        double score = profileScore(points, degrees, bins);
+        if (score > bestScore) {
+            best = degrees;
+            bestScore = score;
+        }
+    }
+    const double coarse = best;
+    for (double degrees = coarse - 0.9; degrees <= coarse + 0.9; degrees += 0.1) {
+        double score = profileScore(points, degrees, bins);
+        if (score > bestScore) {
+            best = degrees;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+/**
+ * Sharpness of the projection profile at one angle
+ *
+ * @param points text pixels
+ * @param degrees angle of the projection
+ * @param bins number of profile bins (at least the diagonal of the image)
+ * @returns sum of squared bin counts
+ */
+double Preprocessor::profileScore(const std::vector<cv::Point> &points, double degrees, int bins)
+{
+    const double radians = degrees * CV_PI / 180.0;
+    const double s = std::sin(radians);
+    const double c = std::cos(radians);
+    std::vector<int> profile(2 * bins + 1, 0);
+    for (const cv::Point &p : points) {
+        // row of the point after rotating the text line into horizontal position
+        int row = cvRound(p.y * c - p.x * s) + bins;
+        ++profile[std::min(std::max(row, 0), 2 * bins)];
+    }
+    double score = 0.0;
+    for (int count : profile) {
+        score += (double)count * count;
+    }
+    return score;
+}
+
+/**
+ * Maps an area of the deskewed frame back to the frame
+ *
+ * @param area in coordinates of the preprocessed frame
+ * @param frame result of process()
+ * @returns bounding rectangle of the rotated area in frame coordinates
+ */
+cv::Rect Preprocessor::mapToSource(const cv::Rect &area, const PreprocessedFrame &frame)
+{
+    if (frame.toSource.empty()) {
+        return area;
+    }
+    std::vector<cv::Point2f> corners = {cv::Point2f((float)area.x, (float)area.y),
+        cv::Point2f((float)area.br().x, (float)area.y), cv::Point2f((float)area.br().x, (float)area.br().y),
+        cv::Point2f((float)area.x, (float)area.br().y)};
+    cv::transform(corners, corners, frame.toSource);
+    return cv::boundingRect(corners);
+}
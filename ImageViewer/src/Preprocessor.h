@@ -0,0 +1,75 @@
+/**
+ * @file Preprocessor.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef PREPROCESSOR_H
+#define PREPROCESSOR_H
+
+// system includes
+#include <vector>
+
+// local includes
+#include "opencv2/opencv.hpp"
+
+/**
+ * Settings of the optional preprocessing prior OCR
+ */
+struct PreprocessSettings
+{
+    bool enabled = false;           // off: the RGB frame is used as is
+    bool binarize = true;           // recognition on a black and white image
+    bool deskew = true;             // rotate text lines into horizontal position
+    int blockSize = 31;             // neighbourhood of the adaptive threshold (odd)
+    int offset = 15;                // pixels darker than the local mean minus offset are text
+    double maxSkew = 10.0;          // largest skew angle searched (degrees)
+    int maxSide = 0;                // larger frames are downscaled first (0: never)
+};
+
+/**
+ * Result of the preprocessing of one frame
+ */
+struct PreprocessedFrame
+{
+    cv::Mat gray;                   // 8 bit grayscale, downscaled and deskewed (input of the detection)
+    cv::Mat binary;                 // 0/255, deskewed (input of the recognition), same as gray if not binarized
+    double angle = 0.0;             // rotation applied to correct the skew (degrees, counter-clockwise)
+    cv::Mat toSource;               // 2x3 affine transformation back to frame coordinates (empty: identity)
+};
+
+/**
+ * Reduces an RGB frame to a single channel before detection and recognition
+ *
+ * Frames larger than maxSide are downscaled first.
+ * Tesseract converts an RGB buffer to 32 bit and thresholds it itself; a
+ * grayscale or binarized frame is a third of the data and the threshold
+ * is already done. The grayscale conversion processes 16 pixels at once
+ * with SSE2 (scalar on other CPUs, with the same result), binarization is
+ * an adaptive mean threshold. The skew is estimated by projection profiles of
+ * the text pixels on a downscaled copy and corrected by rotating the
+ * grayscale frame; areas found on the rotated frame can be mapped back to
+ * the frame with mapToSource().
+ */
+class Preprocessor
+{
+public:
+    static PreprocessedFrame process(const cv::Mat &rgb, const PreprocessSettings &settings);
+
+    static void grayscale(const cv::Mat &rgb, cv::Mat &gray);
+    static void grayscaleScalar(const cv::Mat &rgb, cv::Mat &gray);    // reference of the SSE2 path
+    static void binarize(const cv::Mat &gray, cv::Mat &binary, int blockSize, int offset);
+    static double estimateSkew(const cv::Mat &gray, double maxDegrees);
+    static cv::Rect mapToSource(const cv::Rect &area, const PreprocessedFrame &frame);
+
+private:
+    // weights of ITU-R BT.601 (0.299, 0.587, 0.114) scaled by 256, the sum is 256
+    static const int GRAY_R = 77;
+    static const int GRAY_G = 150;
+    static const int GRAY_B = 29;
+
+    static double profileScore(const std::vector<cv::Point> &points, double degrees, int bins);
+};
+
+#endif // PREPROCESSOR_H
@@ -0,0 +1,134 @@
+// system includes
+#include <QHash>
+#include <QPixmap>
+#include <algorithm>
+
+// local includes
+#include "RegionWatcher.h"
+#include "Tracer.h"
+
+RegionWatcher::RegionWatcher(QObject *parent) : QObject(parent)
+{
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(grab()));
+}
+
+/**
+ * Starts watching a region, the first grab (after one interval) reports the whole region as changed
+ *
+ * @param screen to be grabbed
+ * @param region in logical coordinates of the screen
+ * @param intervalMs time between two grabs
+ */
+void RegionWatcher::start(QScreen *screen, const QRect &region, int intervalMs)
+{
+    m_screen = screen;
+    m_region = region;
+    m_frameSize = QSize();
+    m_hashes.clear();
+    m_timer.start(intervalMs);
+}
+
+/**
+ * Stops grabbing
+ */
+void RegionWatcher::stop()
+{
+    m_timer.stop();
+    m_hashes.clear();
+}
+
+/**
+ * Grabs the region and reports the changed blocks
+ */
+void RegionWatcher::grab()
+{
+    if (m_screen.isNull()) {
+        stop();
+        return;
+    }
+
+    TraceSpan span("watch_grab");
+    SharedImage frame(m_screen->grabWindow(0, m_region.x(), m_region.y(),
+        m_region.width(), m_region.height()).toImage());
+    if (frame.isNull()) {
+        return;
+    }
+
+    const int columns = (frame.width() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const int rows = (frame.height() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    QVector<uint> hashes = blockHashes(frame, columns, rows);
+
+    QVector<QRect> dirty;
+    if (frame.width() != m_frameSize.width() || frame.height() != m_frameSize.height()) {
+        dirty << QRect(0, 0, frame.width(), frame.height());
+    } else {
+        QVector<QRect> blocks;
+        for (int i = 0; i < hashes.size(); ++i) {
+            if (hashes[i] != m_hashes[i]) {
+                blocks << QRect((i % columns) * BLOCK_SIZE, (i / columns) * BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE);
+            }
+        }
+        if (blocks.isEmpty()) {
+            return;     // nothing changed
+        }
+        for (const QRect &rect : mergeRects(blocks)) {
+            dirty << (rect & QRect(0, 0, frame.width(), frame.height()));
+        }
+    }
+
+    m_frameSize = QSize(frame.width(), frame.height());
+    m_hashes = hashes;
+    emit regionChanged(frame, dirty);
+}
+
+/**
+ * Hash of every block, row by row
+ *
+ * @param frame grabbed
+ * @param columns number of blocks per row
+ * @param rows number of block rows
+ * @returns hash per block
+ */
+QVector<uint> RegionWatcher::blockHashes(const SharedImage &frame, int columns, int rows) const
+{
+    QVector<uint> hashes(columns * rows, 0);
+    const QImage &image = frame.qimage();
+    for (int y = 0; y < frame.height(); ++y) {
+        const uchar *line = image.constScanLine(y);
+        uint *blockRow = hashes.data() + (y / BLOCK_SIZE) * columns;
+        for (int column = 0; column < columns; ++column) {
+            const int x = column * BLOCK_SIZE;
+            const int width = std::min(BLOCK_SIZE, frame.width() - x);
+            // the hash of the line continues the hash of the block so far
+            blockRow[column] = qHashBits(line + x * 3, width * 3, blockRow[column]);
+        }
+    }
+    return hashes;
+}
+
+/**
+ * Merges touching or overlapping rectangles into larger ones
+ *
+ * @param rects e.g. changed blocks
+ * @returns rectangles covering all input rectangles
+ */
+QVector<QRect> RegionWatcher::mergeRects(const QVector<QRect> &rects)
+{
+    QVector<QRect> merged = rects;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < merged.size() && !changed; ++i) {
+            for (int j = i + 1; j < merged.size(); ++j) {
+                // rectangles are adjacent if they intersect when grown by one pixel
+                if (merged[i].adjusted(-1, -1, 1, 1).intersects(merged[j])) {
+                    merged[i] = merged[i].united(merged[j]);
+                    merged.remove(j);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return merged;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file RegionWatcher.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef REGIONWATCHER_H
+#define REGIONWATCHER_H
+
+// system includes
+#include <QObject>
+#include <QPointer>
+#include <QRect>
+#include <QScreen>
+#include <QTimer>
+#include <QVector>
+
+// local includes
+#include "SharedImage.h"
+
+/**
+ * Grabs a region of a screen periodically and reports what changed
+ *
+ * Every grab is divided into blocks of BLOCK_SIZE pixels, each block is
+ * hashed and compared with the previous grab. Only when blocks changed,
+ * regionChanged() is emitted with the changed blocks merged into a few
+ * rectangles, so an unchanged screen costs one small grab and hashing per
+ * interval. Grabbing has to happen in the GUI thread.
+ */
+class RegionWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RegionWatcher(QObject *parent=nullptr);
+
+    void start(QScreen *screen, const QRect &region, int intervalMs);
+    void stop();
+    bool isWatching() const { return m_timer.isActive(); }
+
+    static QVector<QRect> mergeRects(const QVector<QRect> &rects);     // merges touching rectangles
+
+public slots:
+    void setInterval(int intervalMs) { m_timer.setInterval(intervalMs); }
+
+signals:
+    void regionChanged(SharedImage frame, QVector<QRect> dirty);    // dirty rectangles in frame pixels
+
+private slots:
+    void grab();
+
+private:
+    static const int BLOCK_SIZE = 32;
+
+    QVector<uint> blockHashes(const SharedImage &frame, int columns, int rows) const;
+
+private:
+    QTimer m_timer;
+    QPointer<QScreen> m_screen;         // reset if the screen is disconnected
+    QRect m_region;                     // logical coordinates on the screen
+    QSize m_frameSize;                  // size of the previous grab (physical pixels)
+    QVector<uint> m_hashes;             // block hashes of the previous grab
+};
+
+#endif // REGIONWATCHER_H
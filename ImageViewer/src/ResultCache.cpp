@@ -0,0 +1,270 @@
+// system includes
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+
+// local includes
+#include "ResultCache.h"
+
+namespace {
+
+const quint32 MAGIC = 0x4f435231;       // "OCR1"
+const char *SUFFIX = ".ocr";
+
+/**
+ * Header of an entry file, followed by the areas (4 x qint32 each) and the
+ * texts (quint32 length followed by the UTF-8 bytes each)
+ */
+struct EntryHeader {
+    quint32 magic;
+    quint32 areaCount;
+    quint32 textCount;
+};
+
+}
+
+/**
+ * Opens the cache in the given directory, existing entries are reused
+ *
+ * @param directory of the entry files (created if missing)
+ * @param maxBytes size limit of all entries
+ */
+ResultCache::ResultCache(const QString &directory, qint64 maxBytes) :
+    m_directory(directory), m_maxBytes(maxBytes), m_totalBytes(0), m_hits(0), m_misses(0)
+{
+    QDir().mkpath(m_directory);
+    scan();
+}
+
+/**
+ * Per-user cache location of the application
+ */
+QString ResultCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/ocr-results";
+}
+
+/**
+ * Computes the content address of an OCR job
+ *
+ * @param image to perform OCR on
+ * @param detectAreas whether text areas are detected prior OCR
+ * @param settings of the detection (only used if detectAreas is set)
+ * @param preprocess settings (only used if enabled)
+ * @param language of the recognition
+ * @param profile name of the OCR profile
+ * @returns hex encoded hash
+ */
+QByteArray ResultCache::key(const SharedImage &image, bool detectAreas,
+    const DetectorSettings &settings, const PreprocessSettings &preprocess, const QString &language,
+    const QString &profile)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    // settings first, so identical pixels with other settings never collide
+    QString description = QString("%1x%2 lang=%3 profile=%4").arg(image.width()).arg(image.height())
+        .arg(language).arg(profile);
+    if (detectAreas) {
+        description += QString(" detect conf=%1 nms=%2 input=%3x%4 model=%5 tile=%6/%7 scale=%8 target=%9 group=%10")
+            .arg(settings.confThreshold).arg(settings.nmsThreshold)
+            .arg(settings.inputWidth).arg(settings.inputHeight)
+            .arg(QString::fromStdString(settings.model))
+            .arg(settings.tileSize).arg(settings.tileOverlap).arg(settings.scale).arg(settings.target)
+            .arg(settings.grouping);
+        if (settings.localityMerge) {
+            description += " lanms";
+        }
+    }
+    if (preprocess.enabled) {
+        description += QString(" preprocess binarize=%1 deskew=%2 block=%3 offset=%4 skew=%5 side=%6")
+            .arg(preprocess.binarize).arg(preprocess.deskew).arg(preprocess.blockSize)
+            .arg(preprocess.offset).arg(preprocess.maxSkew).arg(preprocess.maxSide);
+    }
+    hash.addData(description.toUtf8());
+
+    // only the visible pixels of every line (without padding)
+    const QImage &pixels = image.qimage();
+    const int lineBytes = image.width() * 3;
+    for (int y = 0; y < image.height(); ++y) {
+        hash.addData(reinterpret_cast<const char*>(pixels.constScanLine(y)), lineBytes);
+    }
+    return hash.result().toHex();
+}
+
+/**
+ * Reads an entry from the memory mapped file
+ *
+ * @param key computed with key()
+ * @param result of the job if found
+ * @returns true on a hit
+ */
+bool ResultCache::lookup(const QByteArray &key, CachedResult &result)
+{
+    QMutexLocker locker(&m_mutex);
+
+    result = CachedResult();
+    auto entry = m_entries.find(key);
+    if (entry == m_entries.end()) {
+        ++m_misses;
+        return false;
+    }
+
+    QFile file(pathOf(key));
+    bool ok = file.open(QIODevice::ReadWrite);
+    const qint64 size = ok ? file.size() : 0;
+    const uchar *data = ok && size > 0 ? file.map(0, size) : nullptr;
+    ok = data != nullptr && size >= (qint64)sizeof(EntryHeader);
+
+    EntryHeader header;
+    if (ok) {
+        memcpy(&header, data, sizeof(header));
+        ok = header.magic == MAGIC && (qint64)(sizeof(header) + header.areaCount * 4 * sizeof(qint32)) <= size;
+    }
+
+    qint64 offset = sizeof(header);
+    if (ok) {
+        for (quint32 i = 0; i < header.areaCount; ++i) {
+            qint32 rect[4];
+            memcpy(rect, data + offset, sizeof(rect));
+            offset += sizeof(rect);
+            result.areas << QRect(rect[0], rect[1], rect[2], rect[3]);
+        }
+        for (quint32 i = 0; ok && i < header.textCount; ++i) {
+            quint32 length = 0;
+            ok = offset + (qint64)sizeof(length) <= size;
+            if (ok) {
+                memcpy(&length, data + offset, sizeof(length));
+                offset += sizeof(length);
+                ok = offset + length <= size;
+            }
+            if (ok) {
+                result.texts << QString::fromUtf8(reinterpret_cast<const char*>(data + offset), length);
+                offset += length;
+            }
+        }
+    }
+
+    if (!ok) {
+        // truncated or foreign file: drop it
+        result = CachedResult();
+        file.close();
+        file.remove();
+        m_totalBytes -= entry->size;
+        m_entries.erase(entry);
+        ++m_misses;
+        return false;
+    }
+
+    // the modification time keeps the order of use across restarts
+    entry->lastUsed = QDateTime::currentDateTimeUtc();
+    file.unmap(const_cast<uchar*>(data));
+    file.setFileTime(entry->lastUsed, QFileDevice::FileModificationTime);
+    ++m_hits;
+    return true;
+}
+
+/**
+ * Adds an entry, least recently used entries are evicted if the limit is exceeded
+ *
+ * @param key computed with key()
+ * @param result of the job
+ */
+void ResultCache::store(const QByteArray &key, const CachedResult &result)
+{
+    QByteArray data;
+    EntryHeader header = { MAGIC, (quint32)result.areas.size(), (quint32)result.texts.size() };
+    data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const QRect &area : result.areas) {
+        qint32 rect[4] = { area.x(), area.y(), area.width(), area.height() };
+        data.append(reinterpret_cast<const char*>(rect), sizeof(rect));
+    }
+    for (const QString &text : result.texts) {
+        QByteArray utf8 = text.toUtf8();
+        quint32 length = utf8.size();
+        data.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        data.append(utf8);
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    // written to a temporary file first, a crash never leaves a partial entry
+    QSaveFile file(pathOf(key));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        return;
+    }
+
+    auto entry = m_entries.find(key);
+    if (entry != m_entries.end()) {
+        m_totalBytes -= entry->size;
+    }
+    m_entries[key] = Entry{ data.size(), QDateTime::currentDateTimeUtc() };
+    m_totalBytes += data.size();
+    evict();
+}
+
+/**
+ * Removes all entries
+ */
+void ResultCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        QFile::remove(pathOf(it.key()));
+    }
+    m_entries.clear();
+    m_totalBytes = 0;
+}
+
+int ResultCache::hits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hits;
+}
+
+int ResultCache::misses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_misses;
+}
+
+qint64 ResultCache::totalBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_totalBytes;
+}
+
+void ResultCache::scan()
+{
+    QDir dir(m_directory);
+    const QFileInfoList files = dir.entryInfoList(QStringList() << QString("*") + SUFFIX, QDir::Files);
+    for (const QFileInfo &info : files) {
+        m_entries[info.completeBaseName().toLatin1()] = Entry{ info.size(), info.lastModified().toUTC() };
+        m_totalBytes += info.size();
+    }
+    evict();
+}
+
+void ResultCache::evict()
+{
+    while (m_totalBytes > m_maxBytes && !m_entries.isEmpty()) {
+        auto oldest = m_entries.begin();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->lastUsed < oldest->lastUsed) {
+                oldest = it;
+            }
+        }
+        QFile::remove(pathOf(oldest.key()));
+        m_totalBytes -= oldest->size;
+        m_entries.erase(oldest);
+    }
+}
+
+QString ResultCache::pathOf(const QByteArray &key) const
+{
+    return m_directory + "/" + QString::fromLatin1(key) + SUFFIX;
+}
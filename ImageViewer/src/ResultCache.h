@@ -0,0 +1,85 @@
+/**
+ * @file ResultCache.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+// system includes
+#include <QByteArray>
+#include <QDateTime>
+#include <QMap>
+#include <QMutex>
+#include <QRect>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// local includes
+#include "SharedImage.h"
+#include "TextDetector.h"
+#include "Preprocessor.h"
+
+/**
+ * Result of one OCR job as stored in the cache
+ */
+struct CachedResult
+{
+    QVector<QRect> areas;       // detected text areas (empty if not detected)
+    QStringList texts;          // recognized text per area (one text for the whole image)
+};
+
+/**
+ * Content addressed on-disk cache of OCR results
+ *
+ * The key of an entry is a hash of the pixel data together with all
+ * settings influencing the result, so re-running OCR on the same file or an
+ * identical screen capture is answered without a forward pass or
+ * recognition, even after a restart. Every entry is one small file in the
+ * cache directory which is memory mapped when read. The total size of the
+ * entries is limited, the least recently used entries are evicted first.
+ * All methods are thread safe.
+ */
+class ResultCache
+{
+public:
+    explicit ResultCache(const QString &directory = defaultDirectory(), qint64 maxBytes = 64 * 1024 * 1024);
+
+    static QString defaultDirectory();
+    static QByteArray key(const SharedImage &image, bool detectAreas,
+        const DetectorSettings &settings, const PreprocessSettings &preprocess, const QString &language,
+        const QString &profile);
+
+    bool lookup(const QByteArray &key, CachedResult &result);
+    void store(const QByteArray &key, const CachedResult &result);
+    void clear();
+
+    int hits() const;
+    int misses() const;
+    qint64 totalBytes() const;
+
+private:
+    struct Entry {
+        qint64 size;
+        QDateTime lastUsed;
+    };
+
+    void scan();                // builds the index from the files on disk
+    void evict();               // removes least recently used entries above the limit
+    QString pathOf(const QByteArray &key) const;
+
+private:
+    const QString m_directory;
+    const qint64 m_maxBytes;
+
+    mutable QMutex m_mutex;
+    QMap<QByteArray, Entry> m_entries;      // index of the entries on disk
+    qint64 m_totalBytes;
+    int m_hits;                 // statistics of this session
+    int m_misses;
+};
+
+#endif // RESULTCACHE_H
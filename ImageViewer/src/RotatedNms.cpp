@@ -0,0 +1,202 @@
+// system includes
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// local includes
+#include "RotatedNms.h"
+#include "opencv2/imgproc.hpp"
+
+/**
+ * Non-maximum suppression with the same result as cv::dnn::NMSBoxes (eta 1, no top k)
+ *
+ * @param boxes candidates
+ * @param scores for each candidate
+ * @param scoreThreshold candidates with a score not above are dropped
+ * @param nmsThreshold a candidate is suppressed by a kept box with a larger overlap
+ * @param indices of the kept boxes by descending score
+ */
+void RotatedNms::suppress(const std::vector<cv::RotatedRect> &boxes, const std::vector<float> &scores,
+    float scoreThreshold, float nmsThreshold, std::vector<int> &indices)
+{
+    CV_Assert(boxes.size() == scores.size());
+    indices.clear();
+
+    // same order as NMSBoxes: descending score, ties keep the input order
+    m_order.clear();
+    for (size_t i = 0; i < scores.size(); ++i) {
+        if (scores[i] > scoreThreshold) {
+            m_order.push_back((int)i);
+        }
+    }
+    std::stable_sort(m_order.begin(), m_order.end(), [&scores](int a, int b) { return scores[a] > scores[b]; });
+    if (m_order.empty()) {
+        return;
+    }
+    if (!(nmsThreshold >= 0.0f)) {
+        indices.push_back(m_order.front());    // even disjoint boxes suppress each other
+        return;
+    }
+
+    // bounding rectangles, grown by a pixel so that touching boxes share a cell
+    m_bounds.resize(boxes.size());
+    cv::Point2f minimum(FLT_MAX, FLT_MAX);
+    cv::Point2f maximum(-FLT_MAX, -FLT_MAX);
+    double extent = 0.0;
+    int finite = 0;
+    for (int i : m_order) {
+        cv::Rect2f bounds = boxes[i].boundingRect2f();
+        bounds = cv::Rect2f(bounds.x - 1.0f, bounds.y - 1.0f, bounds.width + 2.0f, bounds.height + 2.0f);
+        m_bounds[i] = bounds;
+        if (std::isfinite(bounds.x) && std::isfinite(bounds.y)
+            && std::isfinite(bounds.width) && std::isfinite(bounds.height)) {
+            minimum = cv::Point2f(std::min(minimum.x, bounds.x), std::min(minimum.y, bounds.y));
+            maximum = cv::Point2f(std::max(maximum.x, bounds.br().x), std::max(maximum.y, bounds.br().y));
+            extent += std::max(bounds.width, bounds.height);
+            ++finite;
+        }
+    }
+    if (finite == 0) {
+        minimum = maximum = cv::Point2f(0.0f, 0.0f);
+    }
+
+    // cells of about the size of a box, so a box covers only a few cells
+    m_origin = minimum;
+    m_cellSize = std::min(std::max(finite > 0 ? (float)(extent / finite) : 1.0f, 8.0f), 256.0f);
+    const float width = maximum.x - minimum.x;
+    const float height = maximum.y - minimum.y;
+    const double cells = std::ceil(width / m_cellSize + 1.0) * std::ceil(height / m_cellSize + 1.0);
+    if (cells > MAX_CELLS) {
+        m_cellSize *= (float)std::sqrt(cells / MAX_CELLS) * 1.01f;
+    }
+    m_columns = (int)(width / m_cellSize) + 1;
+    m_rows = (int)(height / m_cellSize) + 1;
+
+    const size_t cellCount = (size_t)m_columns * m_rows;
+    if (m_cells.size() < cellCount) {
+        m_cells.resize(cellCount);
+    }
+    for (size_t c = 0; c < cellCount; ++c) {
+        m_cells[c].clear();
+    }
+    m_checked.assign(boxes.size(), -1);
+
+    for (int i : m_order) {
+        const cv::Rect range = cellRange(m_bounds[i]);
+
+        // compare with the kept boxes near the candidate only, each of them once
+        bool keep = true;
+        for (int y = range.y; keep && y < range.y + range.height; ++y) {
+            for (int x = range.x; keep && x < range.x + range.width; ++x) {
+                for (int k : m_cells[(size_t)y * m_columns + x]) {
+                    if (m_checked[k] == i) {
+                        continue;
+                    }
+                    m_checked[k] = i;
+                    if (apart(m_bounds[k], m_bounds[i])) {
+                        continue;   // no overlap
+                    }
+                    if (!(overlap(boxes[i], boxes[k]) <= nmsThreshold)) {
+                        keep = false;
+                        break;
+                    }
+                }
+            }
+        }
+        if (!keep) {
+            continue;
+        }
+
+        indices.push_back(i);
+        for (int y = range.y; y < range.y + range.height; ++y) {
+            for (int x = range.x; x < range.x + range.width; ++x) {
+                m_cells[(size_t)y * m_columns + x].push_back(i);
+            }
+        }
+    }
+}
+
+/**
+ * Cells covered by a bounding rectangle (all cells if it isn't finite)
+ *
+ * @param bounds of a box
+ * @returns range of cell columns and rows
+ */
+cv::Rect RotatedNms::cellRange(const cv::Rect2f &bounds) const
+{
+    // written so that NaN ends up at the border of the grid
+    const float left = (bounds.x - m_origin.x) / m_cellSize;
+    const float top = (bounds.y - m_origin.y) / m_cellSize;
+    const float right = (bounds.x + bounds.width - m_origin.x) / m_cellSize;
+    const float bottom = (bounds.y + bounds.height - m_origin.y) / m_cellSize;
+    const int x0 = (int)std::max(0.0f, std::min(left, (float)(m_columns - 1)));
+    const int y0 = (int)std::max(0.0f, std::min(top, (float)(m_rows - 1)));
+    const int x1 = (int)std::min((float)(m_columns - 1), std::max(right, 0.0f));
+    const int y1 = (int)std::min((float)(m_rows - 1), std::max(bottom, 0.0f));
+    return cv::Rect(x0, y0, std::max(x1 - x0 + 1, 1), std::max(y1 - y0 + 1, 1));
+}
+
+/**
+ * Bounding rectangles which are separated (false if one of them isn't finite)
+ */
+bool RotatedNms::apart(const cv::Rect2f &a, const cv::Rect2f &b)
+{
+    return a.x + a.width < b.x || b.x + b.width < a.x || a.y + a.height < b.y || b.y + b.height < a.y;
+}
+
+/**
+ * Locality-aware merge of consecutive candidates (EAST, applied before suppress())
+ *
+ * The decoder emits the candidates row by row over the score map, so the
+ * boxes of one word follow each other. A candidate which overlaps the
+ * previous (already merged) box by more than the threshold is merged into
+ * it: center, size and angle are averaged weighted by the scores and the
+ * scores add up, so well supported boxes win the suppression afterwards.
+ *
+ * @param boxes candidates, replaced by the merged boxes
+ * @param scores for each candidate, replaced accordingly
+ * @param nmsThreshold minimum overlap to merge two boxes
+ */
+void RotatedNms::mergeLocal(std::vector<cv::RotatedRect> &boxes, std::vector<float> &scores, float nmsThreshold)
+{
+    CV_Assert(boxes.size() == scores.size());
+    size_t merged = 0;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        if (merged > 0 && overlap(boxes[merged - 1], boxes[i]) > nmsThreshold) {
+            cv::RotatedRect &last = boxes[merged - 1];
+            const float w0 = scores[merged - 1];
+            const float w1 = scores[i];
+            const float sum = w0 + w1;
+            last.center = (last.center * w0 + boxes[i].center * w1) / sum;
+            last.size = cv::Size2f((last.size.width * w0 + boxes[i].size.width * w1) / sum,
+                (last.size.height * w0 + boxes[i].size.height * w1) / sum);
+            last.angle = (last.angle * w0 + boxes[i].angle * w1) / sum;
+            scores[merged - 1] = sum;
+        } else {
+            boxes[merged] = boxes[i];
+            scores[merged] = scores[i];
+            ++merged;
+        }
+    }
+    boxes.resize(merged);
+    scores.resize(merged);
+}
+
+/**
+ * Intersection over union of two rotated rectangles (as used by cv::dnn::NMSBoxes)
+ *
+ * @returns 0 if they don't intersect, 1 if one contains the other
+ */
+float RotatedNms::overlap(const cv::RotatedRect &a, const cv::RotatedRect &b)
+{
+    std::vector<cv::Point2f> intersection;
+    const int result = cv::rotatedRectangleIntersection(a, b, intersection);
+    if (intersection.empty() || result == cv::INTERSECT_NONE) {
+        return 0.0f;
+    }
+    if (result == cv::INTERSECT_FULL) {
+        return 1.0f;
+    }
+    const float area = (float)cv::contourArea(intersection);
+    return area / (a.size.area() + b.size.area() - area);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file RotatedNms.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef ROTATEDNMS_H
+#define ROTATEDNMS_H
+
+// system includes
+#include <vector>
+
+// local includes
+#include "opencv2/core.hpp"
+
+/**
+ * Non-maximum suppression of rotated boxes using a spatial grid
+ *
+ * cv::dnn::NMSBoxes compares every candidate with every box kept so far,
+ * which grows quadratically with the number of candidates on dense pages.
+ * RotatedNms visits the candidates in the same order (descending score,
+ * ties in input order) and uses the same overlap (intersection over union
+ * of the rotated rectangles), but the kept boxes are bucketed into a grid
+ * by their bounding rectangles. A candidate is only compared with the kept
+ * boxes of the cells it covers; boxes whose bounding rectangles do not
+ * touch have no overlap and could not suppress it anyway, so the surviving
+ * set is exactly the one of NMSBoxes. Optionally, consecutive candidates
+ * of the decoder (row by row over the score map) are merged first
+ * (locality-aware NMS as proposed with EAST), which shrinks the candidate
+ * set before suppression but changes the result. The buffers are reused
+ * from call to call, so an instance should live as long as its detector.
+ */
+class RotatedNms
+{
+public:
+    void suppress(const std::vector<cv::RotatedRect> &boxes, const std::vector<float> &scores,
+        float scoreThreshold, float nmsThreshold, std::vector<int> &indices);
+    static void mergeLocal(std::vector<cv::RotatedRect> &boxes, std::vector<float> &scores, float nmsThreshold);
+    static float overlap(const cv::RotatedRect &a, const cv::RotatedRect &b);     // same IoU as NMSBoxes
+
+private:
+    static const int MAX_CELLS = 1 << 16;   // the cells get larger for very large extents
+
+    cv::Rect cellRange(const cv::Rect2f &bounds) const;
+    static bool apart(const cv::Rect2f &a, const cv::Rect2f &b);
+
+private:
+    std::vector<int> m_order;               // candidates above the threshold by descending score
+    std::vector<cv::Rect2f> m_bounds;       // bounding rectangle of every box
+    std::vector<std::vector<int>> m_cells;  // kept boxes per cell (capacity is kept between calls)
+    std::vector<int> m_checked;             // candidate a kept box was last compared with
+    cv::Point2f m_origin;                   // top left corner of the grid
+    float m_cellSize = 1.0f;
+    int m_columns = 0;
+    int m_rows = 0;
+};
+
+#endif // ROTATEDNMS_H
@@ -0,0 +1,48 @@
+// local includes
+#include "SharedImage.h"
+
+SharedImage::SharedImage()
+{
+}
+
+/**
+ * Shares the buffer of an image, other formats are converted to 8 bit RGB once
+ *
+ * @param image to be shared
+ */
+SharedImage::SharedImage(const QImage &image)
+{
+    if (image.format() == QImage::Format_RGB888) {
+        m_image = image;
+    } else if (!image.isNull()) {
+        // convertion to 8 bit RGB allows any input format
+        m_image = image.convertToFormat(QImage::Format_RGB888);
+    }
+}
+
+/**
+ * Loads an image from a file
+ *
+ * @param path of the image
+ * @returns image (null if it could not be read)
+ */
+SharedImage SharedImage::fromFile(const QString &path)
+{
+    return SharedImage(QImage(path));
+}
+
+ * View of the pixels as OpenCV matrix (TextRecognizer::setImage() copies it for Tesseract)
+ * View of the pixels as OpenCV matrix, which can also be passed to Tesseract
+ * Only the header is created, the buffer is shared and must not be modified.
+ *
+ * @returns CV_8UC3 (RGB) matrix
+ */
+cv::Mat SharedImage::mat() const
+{
+    if (m_image.isNull()) {
+        return cv::Mat();
+    }
+    // constBits() does not detach the shared buffer
+    return cv::Mat(m_image.height(), m_image.width(), CV_8UC3,
+        const_cast<uchar*>(m_image.constBits()), m_image.bytesPerLine());
+}
@@ -0,0 +1,51 @@
+/**
+ * @file SharedImage.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef SHAREDIMAGE_H
+#define SHAREDIMAGE_H
+
+// system includes
+#include <QImage>
+#include <QMetaType>
+#include <QString>
+
+// local includes
+#include "opencv2/opencv.hpp"
+
+/**
+ * Reference counted, read only image buffer shared by Qt and OpenCV
+ *
+ * SharedImage holds the pixels in a format all libraries understand
+ * (8 bit RGB, converted once when the image is created).
+ * Copies only increase the reference count of the buffer. Qt (qimage())
+ * and OpenCV (mat()) work on views of the same pixels. Tesseract gets its
+ * own copy in TextRecognizer::setImage(). The pixels must not be modified
+ * through any of the views.
+ */
+class SharedImage
+{
+public:
+    SharedImage();
+    explicit SharedImage(const QImage &image);
+
+    static SharedImage fromFile(const QString &path);
+
+    bool isNull() const { return m_image.isNull(); }
+    int width() const { return m_image.width(); }
+    int height() const { return m_image.height(); }
+    size_t byteCount() const { return (size_t)m_image.bytesPerLine() * m_image.height(); }
+
+    const QImage &qimage() const { return m_image; }
+    cv::Mat mat() const;            // OpenCV view of the pixels (not copied)
+
+private:
+    QImage m_image;                 // implicitly shared buffer (RGB888)
+};
+
+Q_DECLARE_METATYPE(SharedImage)
+
+#endif // SHAREDIMAGE_H
@@ -0,0 +1,515 @@
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// local includes
+#include "TextDetector.h"
+#include "ModelStore.h"
+#include "Tracer.h"
+
+TextDetector::TextDetector(const DetectorSettings &settings) : m_settings(settings),
+    m_warmUpMs(0.0), m_lastForwardMs(0.0), m_totalForwardMs(0.0), m_forwardCount(0)
+{
+}
+
+/**
+ * Changes the settings, the model is reloaded if a different one is requested
+ *
+ * @param settings to be used for the next detections
+ */
+void TextDetector::setSettings(const DetectorSettings &settings)
+{
+    if (settings.model != m_settings.model) {
+        m_net = cv::dnn::Net();
+    } else if (!m_net.empty() && (settings.backend != m_settings.backend || settings.target != m_settings.target)) {
+        m_net.setPreferableBackend(settings.backend);
+        m_net.setPreferableTarget(settings.target);
+    }
+    m_settings = settings;
+}
+
+/**
+ * Loads the pretrained EAST model, only done once per detector
+ *
+ * @returns true if the network is ready to be used
+ */
+bool TextDetector::load()
+{
+    if (m_net.empty()) {
+        try {
+            // TensorFlow models are parsed from the shared mapping of the file
+            const std::string &model = m_settings.model;
+            std::shared_ptr<const MappedFile> file;
+            if (model.size() > 3 && model.compare(model.size() - 3, 3, ".pb") == 0) {
+                file = ModelStore::instance().map(model);
+            }
+            m_net = file ? cv::dnn::readNetFromTensorflow(file->data(), file->size()) : cv::dnn::readNet(model);
+            m_net.setPreferableBackend(m_settings.backend);
+            m_net.setPreferableTarget(m_settings.target);
+            if (m_settings.warmUp && !m_net.empty()) {
+                warmUp();
+            }
+        } catch (const cv::Exception &) {
+            m_net = cv::dnn::Net();
+            return false;
+        }
+    }
+    return !m_net.empty();
+}
+
+/**
+ * One forward pass with a blank input of the size used for detection
+ * The first pass initializes the backend and is much slower than the following ones.
+ */
+void TextDetector::warmUp()
+{
+    const bool tiled = m_settings.tileSize > 0;
+    const int width = tiled ? std::max(32, m_settings.tileSize / 32 * 32) : m_settings.inputWidth;
+    const int height = tiled ? width : m_settings.inputHeight;
+    int sizes[] = {1, 3, height, width};
+    cv::Mat blob(4, sizes, CV_32F, cv::Scalar(0));
+
+    std::vector<cv::Mat> outs;
+    forward(blob, outs);
+    m_warmUpMs = m_lastForwardMs;
+    // the warm-up does not count for the average
+    m_totalForwardMs = 0.0;
+    m_forwardCount = 0;
+}
+
+/**
+ * Average latency of all forward passes (without warm-up)
+ *
+ * @returns latency in milliseconds
+ */
+double TextDetector::averageForwardMs() const
+{
+    return m_forwardCount > 0 ? m_totalForwardMs / m_forwardCount : 0.0;
+}
+
+/**
+ * To detect text areas using openCV
+ *
+ * @param frame (8 bit, 3 channels or grayscale) to perform text detection on
+ * @param areas holding the detected areas in frame coordinates
+ * @returns false if the model could not be loaded
+ */
+bool TextDetector::detect(const cv::Mat &frame, std::vector<cv::Rect> &areas)
+{
+    // Load dnn network
+    if (!load()) {
+        return false;
+    }
+
+    if (m_settings.tileSize > 0) {
+        detectTiles(frame, areas);
+    } else {
+        std::vector<std::vector<cv::Rect>> frameAreas;
+        detectFrames(std::vector<cv::Mat>(1, frame), frameAreas);
+        areas.insert(areas.end(), frameAreas[0].begin(), frameAreas[0].end());
+    }
+    return true;
+}
+
+/**
+ * To detect text areas on several images with a single forward pass
+ * In tiled mode every image is detected on its own (its tiles form the batch).
+ *
+ * @param frames (8 bit, 3 channels or grayscale) to perform text detection on
+ * @param areas holding the detected areas in frame coordinates, one list per frame
+ * @returns false if the model could not be loaded
+ */
+bool TextDetector::detect(const std::vector<cv::Mat> &frames, std::vector<std::vector<cv::Rect>> &areas)
+{
+    if (!load()) {
+        return false;
+    }
+
+    areas.assign(frames.size(), std::vector<cv::Rect>());
+    if (frames.empty()) {
+        return true;
+    }
+    if (m_settings.tileSize > 0) {
+        for (size_t n = 0; n < frames.size(); ++n) {
+            detectTiles(frames[n], areas[n]);
+        }
+    } else {
+        detectFrames(frames, areas);
+    }
+    return true;
+}
+
+/**
+ * Passes a blob through the network and returns the two output layers
+ *
+ * @param blob holding one or more images
+ * @param outs scores (first) and geometry (second) of every image
+ */
+void TextDetector::forward(const cv::Mat &blob, std::vector<cv::Mat> &outs)
+{
+    std::vector<std::string> layerNames(2);                 // names of the two layers used
+    layerNames[0] = "feature_fusion/Conv_7/Sigmoid";        // sogmoid activation - wheter given region has text or no
+    layerNames[1] = "feature_fusion/concat_3";              // feature map output - containing geometry of the image
+
+    TraceSpan span("forward");
+    auto start = std::chrono::steady_clock::now();
+
+    // pass input layer (blob) to dnn model and perform a round of forwarding
+    m_net.setInput(blob);
+    // outs contains the two output layers
+    m_net.forward(outs, layerNames);
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    m_lastForwardMs = elapsed.count();
+    m_totalForwardMs += m_lastForwardMs;
+    ++m_forwardCount;
+}
+
+/**
+ * Detects text areas on whole frames squashed into the network input size
+ * All frames are packed into one blob and passed through the network at once.
+ *
+ * @param frames (8 bit, 3 channels) to perform text detection on
+ * @param areas holding the detected areas in frame coordinates, one list per frame
+ */
+void TextDetector::detectFrames(const std::vector<cv::Mat> &frames, std::vector<std::vector<cv::Rect>> &areas)
+{
+    const int inputWidth = m_settings.inputWidth;
+    const int inputHeight = m_settings.inputHeight;
+
+    std::vector<cv::Mat> outs;                              // output layers of the model
+    cv::Mat blob;
+
+    // blobFromImages(input, output, scale factor, output size, training mean, swap R and B channel, crop output)
+    {
+        TraceSpan span("blob_from_image");
+        // the network expects 3 channels, grayscale frames are expanded after resizing (less data)
+        std::vector<cv::Mat> inputs = frames;
+        for (cv::Mat &input : inputs) {
+            if (input.channels() == 1) {
+                cv::Mat resized;
+                cv::resize(input, resized, cv::Size(inputWidth, inputHeight));
+                cv::cvtColor(resized, input, cv::COLOR_GRAY2RGB);
+            }
+        }
+        cv::dnn::blobFromImages( inputs, blob, 1.0, cv::Size(inputWidth, inputHeight),
+            cv::Scalar(123.68, 116.78, 103.94), true, false
+        ); // cv::Scalar holds the (rgb) mean used while the model was trained
+    }
+    forward(blob, outs);
+
+    areas.resize(frames.size());
+    for (size_t n = 0; n < frames.size(); ++n) {
+        const cv::Mat &frame = frames[n];
+
+        // extract the two layers of this frame
+        cv::Mat scores = layerOf(outs[0], (int)n);
+        cv::Mat geometry = layerOf(outs[1], (int)n);
+
+        // decode the layers into candidate text areas (boxes) and corresponding confidences
+        std::vector<cv::RotatedRect> boxes;
+        std::vector<float> confidences;
+        {
+            TraceSpan span("decode", (int)n);
+            m_decoder.decode(scores, geometry, m_settings.confThreshold, boxes, confidences);
+        }
+
+        // filter the candidate areas using non-max suppression
+        std::vector<int> indices;
+        {
+            TraceSpan span("nms", (int)n);
+            if (m_settings.localityMerge) {
+                RotatedNms::mergeLocal(boxes, confidences, m_settings.nmsThreshold);
+            }
+            m_nms.suppress(boxes, confidences, m_settings.confThreshold, m_settings.nmsThreshold, indices);
+        }
+
+        // resizing ratio of boxes
+        cv::Point2f ratio((float)frame.cols / inputWidth, (float)frame.rows / inputHeight);
+
+        // iterate over indices and collect rectangles
+        for (size_t i = 0; i < indices.size(); ++i) {
+            cv::RotatedRect& box = boxes[indices[i]];
+            cv::Rect area = box.boundingRect();
+
+            // reverse resizing for the rectangles
+            area.x *= ratio.x;
+            area.width *= ratio.x;
+            area.y *= ratio.y;
+            area.height *= ratio.y;
+            areas[n].push_back(area);
+        }
+    }
+}
+
+/**
+ * View of the output layer of a single image of a batch
+ *
+ * @param out output layer of the whole batch (N x C x H x W)
+ * @param n index of the image
+ * @returns layer of the image (1 x C x H x W, not copied)
+ */
+cv::Mat TextDetector::layerOf(const cv::Mat &out, int n)
+{
+    int sizes[] = {1, out.size[1], out.size[2], out.size[3]};
+    return cv::Mat(4, sizes, CV_32F, const_cast<float*>(out.ptr<float>(n)));
+}
+
+/**
+ * Detects text areas on overlapping tiles of the (scaled) frame
+ * The tiles are not resized, so the aspect ratio of the text is kept.
+ *
+ * @param frame (8 bit, 3 channels) to perform text detection on
+ * @param areas holding the detected areas in frame coordinates
+ */
+void TextDetector::detectTiles(const cv::Mat &frame, std::vector<cv::Rect> &areas)
+{
+    const float scale = m_settings.scale > 0.0f ? m_settings.scale : 1.0f;
+    const int tileSize = std::max(32, m_settings.tileSize / 32 * 32);   // EAST requires multiple of 32
+    const int overlap = std::min(std::max(0, m_settings.tileOverlap), tileSize / 2);
+
+    TraceSpan tilesSpan("tiles");
+    cv::Mat scaled = frame;
+    if (scale != 1.0f) {
+        cv::resize(frame, scaled, cv::Size(), scale, scale, scale < 1.0f ? cv::INTER_AREA : cv::INTER_LINEAR);
+    }
+
+    // cut the tiles, tiles at the border of small images are padded
+    std::vector<cv::Rect> tiles = tileGrid(scaled.size(), tileSize, overlap);
+    std::vector<cv::Mat> crops;
+    for (const cv::Rect &tile : tiles) {
+        cv::Mat crop = scaled(tile & cv::Rect(0, 0, scaled.cols, scaled.rows));
+        if (crop.cols != tileSize || crop.rows != tileSize) {
+            cv::Mat padded;
+            cv::copyMakeBorder(crop, padded, 0, tileSize - crop.rows, 0, tileSize - crop.cols,
+                cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+            crop = padded;
+        }
+        if (crop.channels() == 1) {
+            cv::Mat rgb;
+            cv::cvtColor(crop, rgb, cv::COLOR_GRAY2RGB);
+            crop = rgb;
+        }
+        crops.push_back(crop);
+    }
+
+    // all tiles are passed through the network in one batch
+    cv::Mat blob;
+    {
+        TraceSpan span("blob_from_image");
+        cv::dnn::blobFromImages( crops, blob, 1.0, cv::Size(tileSize, tileSize),
+            cv::Scalar(123.68, 116.78, 103.94), true, false
+        );
+    }
+    std::vector<cv::Mat> outs;
+    forward(blob, outs);
+
+    // decode every tile and move its boxes into scaled frame coordinates
+    std::vector<cv::RotatedRect> boxes;
+    std::vector<float> confidences;
+    std::vector<int> tileOf;                                // tile index of every box
+    for (size_t n = 0; n < tiles.size(); ++n) {
+        cv::Mat scores = layerOf(outs[0], (int)n);
+        cv::Mat geometry = layerOf(outs[1], (int)n);
+
+        std::vector<cv::RotatedRect> tileBoxes;
+        std::vector<float> tileConfidences;
+        {
+            TraceSpan span("decode", (int)n);
+            m_decoder.decode(scores, geometry, m_settings.confThreshold, tileBoxes, tileConfidences);
+        }
+
+        for (size_t i = 0; i < tileBoxes.size(); ++i) {
+            cv::RotatedRect box = tileBoxes[i];
+            box.center += cv::Point2f((float)tiles[n].x, (float)tiles[n].y);
+            boxes.push_back(box);
+            confidences.push_back(tileConfidences[i]);
+            tileOf.push_back((int)n);
+        }
+    }
+
+    // boxes of words crossing a seam are merged with their other half
+    {
+        TraceSpan span("merge_seams");
+        mergeSeams(tiles, scaled.size(), tileOf, boxes, confidences);
+    }
+
+    // filter the candidate areas using non-max suppression
+    std::vector<int> indices;
+    {
+        TraceSpan span("nms");
+        if (m_settings.localityMerge) {
+            RotatedNms::mergeLocal(boxes, confidences, m_settings.nmsThreshold);
+        }
+        m_nms.suppress(boxes, confidences, m_settings.confThreshold, m_settings.nmsThreshold, indices);
+    }
+
+    // reverse scaling for the rectangles
+    cv::Rect bounds(0, 0, frame.cols, frame.rows);
+    for (int index : indices) {
+        cv::Rect2f box = boxes[index].boundingRect2f();
+        cv::Rect area(cvFloor(box.x / scale), cvFloor(box.y / scale),
+            cvCeil(box.width / scale), cvCeil(box.height / scale));
+        area &= bounds;
+        if (!area.empty()) {
+            areas.push_back(area);
+        }
+    }
+}
+
+/**
+ * Splits an image into overlapping square tiles
+ * The last tile of a row or column is aligned with the image border.
+ *
+ * @param size of the image
+ * @param tileSize edge length of the tiles
+ * @param overlap of neighbouring tiles
+ * @returns tiles in image coordinates (may exceed images smaller than a tile)
+ */
+std::vector<cv::Rect> TextDetector::tileGrid(const cv::Size &size, int tileSize, int overlap)
+{
+    auto origins = [tileSize, overlap](int length) {
+        std::vector<int> positions;
+        const int step = std::max(1, tileSize - overlap);
+        int position = 0;
+        for (; position + tileSize < length; position += step) {
+            positions.push_back(position);
+        }
+        positions.push_back(std::max(0, length - tileSize));
+        return positions;
+    };
+
+    std::vector<cv::Rect> tiles;
+    for (int y : origins(size.height)) {
+        for (int x : origins(size.width)) {
+            tiles.push_back(cv::Rect(x, y, tileSize, tileSize));
+        }
+    }
+    return tiles;
+}
+
+/**
+ * Merges boxes cut by an inner tile seam with the overlapping box of a neighbouring tile
+ * A merged box is the axis aligned union of both halves with the higher confidence.
+ *
+ * @param tiles in (scaled) frame coordinates
+ * @param size of the (scaled) frame
+ * @param tileOf tile index of every box
+ * @param boxes candidate boxes in (scaled) frame coordinates
+ * @param confidences for each candidate
+ */
+void TextDetector::mergeSeams(const std::vector<cv::Rect> &tiles, const cv::Size &size,
+    const std::vector<int> &tileOf, std::vector<cv::RotatedRect> &boxes,
+    std::vector<float> &confidences)
+{
+    const float margin = 8.0f;      // two cells of the score map
+
+    std::vector<cv::Rect2f> rects;
+    rects.reserve(boxes.size());
+    for (const cv::RotatedRect &box : boxes) {
+        rects.push_back(box.boundingRect2f());
+    }
+
+    std::vector<cv::RotatedRect> merged = boxes;
+    std::vector<float> mergedConfidences = confidences;
+    for (size_t i = 0; i < rects.size(); ++i) {
+        const cv::Rect &tile = tiles[tileOf[i]];
+        const cv::Rect2f &r = rects[i];
+
+        // is the box cut by a seam inside the image (left/right or top/bottom)?
+        bool cutX = (tile.x > 0 && r.x <= tile.x + margin)
+            || (tile.br().x < size.width && r.br().x >= tile.br().x - margin);
+        bool cutY = (tile.y > 0 && r.y <= tile.y + margin)
+            || (tile.br().y < size.height && r.br().y >= tile.br().y - margin);
+        if (!cutX && !cutY) {
+            continue;
+        }
+
+        // find the other half: largest intersection with a box of another tile on the same line
+        int best = -1;
+        float bestArea = 0.0f;
+        for (size_t j = 0; j < rects.size(); ++j) {
+            if (tileOf[j] == tileOf[i]) {
+                continue;
+            }
+            cv::Rect2f inter = r & rects[j];
+            if (inter.area() <= bestArea) {
+                continue;
+            }
+            bool sameLine = !cutX || inter.height >= 0.5f * std::min(r.height, rects[j].height);
+            bool sameColumn = !cutY || inter.width >= 0.5f * std::min(r.width, rects[j].width);
+            if (sameLine && sameColumn) {
+                best = (int)j;
+                bestArea = inter.area();
+            }
+        }
+        if (best < 0) {
+            continue;
+        }
+
+        cv::Rect2f u = r | rects[best];
+        merged[i] = cv::RotatedRect(cv::Point2f(u.x + 0.5f * u.width, u.y + 0.5f * u.height),
+            cv::Size2f(u.width, u.height), 0.0f);
+        mergedConfidences[i] = std::max(confidences[i], confidences[best]);
+    }
+    boxes.swap(merged);
+    confidences.swap(mergedConfidences);
+}
+
+/**
+ * Extract confidences and area from dnn output layers
+ * Comment: I used the following repository:
+ * https://github.com/opencv/opencv/blob/master/samples/dnn/text_detection.cpp#L119
+ *
+ * @param scores of each of the detected areas (first layer output)
+ * @param geometry information of the image (second layer output)
+ * @param scoreThresh = confidence threshold
+ * @param detections of possible area candidates
+ * @param confidences for each candidate
+ */
+void TextDetector::decode(const cv::Mat& scores, const cv::Mat& geometry, float scoreThresh,
+    std::vector<cv::RotatedRect>& detections, std::vector<float>& confidences)
+{
+    CV_Assert(scores.dims == 4); CV_Assert(geometry.dims == 4);
+    CV_Assert(scores.size[0] == 1); CV_Assert(scores.size[1] == 1);
+    CV_Assert(geometry.size[0] == 1);  CV_Assert(geometry.size[1] == 5);
+    CV_Assert(scores.size[2] == geometry.size[2]);
+    CV_Assert(scores.size[3] == geometry.size[3]);
+
+    detections.clear();
+    const int height = scores.size[2];
+    const int width = scores.size[3];
+    for (int y = 0; y < height; ++y) {
+        const float* scoresData = scores.ptr<float>(0, 0, y);
+        const float* x0_data = geometry.ptr<float>(0, 0, y);
+        const float* x1_data = geometry.ptr<float>(0, 1, y);
+        const float* x2_data = geometry.ptr<float>(0, 2, y);
+        const float* x3_data = geometry.ptr<float>(0, 3, y);
+        const float* anglesData = geometry.ptr<float>(0, 4, y);
+
+        for (int x = 0; x < width; ++x) {
+            float score = scoresData[x];
+            if (score < scoreThresh)
+                continue;
+
+            // Decode a prediction.
+            // Multiple by 4 because feature maps are 4 time less than input image.
+            float offsetX = x * 4.0f, offsetY = y * 4.0f;
+            float angle = anglesData[x];
+            float cosA = std::cos(angle);
+            float sinA = std::sin(angle);
+            float h = x0_data[x] + x2_data[x];
+            float w = x1_data[x] + x3_data[x];
+
+            // map the text areas (from resized image) back to the original input image
+            cv::Point2f offset(offsetX + cosA * x1_data[x] + sinA * x2_data[x],
+                offsetY - sinA * x1_data[x] + cosA * x2_data[x]);
+            cv::Point2f p1 = cv::Point2f(-sinA * h, -cosA * h) + offset;
+            cv::Point2f p3 = cv::Point2f(-cosA * w, sinA * w) + offset;
+            cv::RotatedRect r(0.5f * (p1 + p3), cv::Size2f(w, h), -angle * 180.0f / (float)CV_PI);
+            detections.push_back(r);
+            confidences.push_back(score);
+        } // end for
+    } // end for
+} // end decode
@@ -0,0 +1,99 @@
+/**
+ * @file TextDetector.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef TEXTDETECTOR_H
+#define TEXTDETECTOR_H
+
+// system includes
+#include <string>
+#include <vector>
+
+// local includes
+#include "opencv2/opencv.hpp"
+#include "opencv2/dnn.hpp"
+#include "EastDecoder.h"
+#include "RotatedNms.h"
+#include "TextGrouper.h"
+
+/**
+ * Settings of the EAST text area detection
+ */
+struct DetectorSettings
+{
+    float confThreshold = 0.5f;                              // confidence threshold
+    float nmsThreshold = 0.4f;                               // non-maximum suppression
+    bool localityMerge = false;                              // merge neighbouring candidates prior NMS (EAST)
+    int inputWidth = 320;                                    // EAST requires multiple of 32
+    int inputHeight = 320;
+    std::string model = "./frozen_east_text_detection.pb";   // pretrained model data
+    int tileSize = 0;                                        // 0: whole frame, else tile size (multiple of 32)
+    int tileOverlap = 64;                                    // overlap of neighbouring tiles
+    float scale = 1.0f;                                      // scaling of the frame prior tiling
+    int backend = cv::dnn::DNN_BACKEND_DEFAULT;              // cv::dnn::Backend
+    int target = cv::dnn::DNN_TARGET_CPU;                    // cv::dnn::Target (device and precision)
+    bool warmUp = false;                                     // one forward pass right after loading
+    int grouping = TextGrouper::Lines;                       // TextGrouper::Mode applied before recognition
+};
+
+/**
+ * Text area detection using the EAST deep neural network
+ *
+ * TextDetector owns one instance of the pretrained EAST model (loaded
+ * lazily on first use) and turns an RGB frame into a list of axis aligned
+ * text areas in frame coordinates. A detector is not thread safe, use one
+ * instance per thread.
+ * By default the whole frame is squashed into the network input size. For
+ * high resolution images a tiled mode is available: the (optionally scaled)
+ * frame is split into overlapping square tiles which keep the aspect ratio,
+ * all tiles are passed through the network as one batch and boxes cut by a
+ * tile seam are merged before non-maximum suppression.
+ * Several frames can be detected with a single forward pass (batch).
+ */
+class TextDetector
+{
+public:
+    explicit TextDetector(const DetectorSettings &settings = DetectorSettings());
+
+    bool load();                // load the dnn model (if not done yet)
+    bool detect(const cv::Mat &frame, std::vector<cv::Rect> &areas);
+    bool detect(const std::vector<cv::Mat> &frames, std::vector<std::vector<cv::Rect>> &areas);
+
+    const DetectorSettings &settings() const { return m_settings; }
+    void setSettings(const DetectorSettings &settings);
+
+    double warmUpMs() const { return m_warmUpMs; }              // latency of the warm-up pass
+    double lastForwardMs() const { return m_lastForwardMs; }    // latency of the last forward pass
+    double averageForwardMs() const;
+
+    // scalar reference decoder, the detection itself uses EastDecoder
+    static void decode(const cv::Mat& scores, const cv::Mat& geometry, float scoreThresh,
+        std::vector<cv::RotatedRect>& detections, std::vector<float>& confidences);
+
+private:
+    void detectFrames(const std::vector<cv::Mat> &frames, std::vector<std::vector<cv::Rect>> &areas);
+    void detectTiles(const cv::Mat &frame, std::vector<cv::Rect> &areas);
+    void forward(const cv::Mat &blob, std::vector<cv::Mat> &outs);
+    void warmUp();
+
+    static cv::Mat layerOf(const cv::Mat &out, int n);
+    static std::vector<cv::Rect> tileGrid(const cv::Size &size, int tileSize, int overlap);
+    static void mergeSeams(const std::vector<cv::Rect> &tiles, const cv::Size &size,
+        const std::vector<int> &tileOf, std::vector<cv::RotatedRect> &boxes,
+        std::vector<float> &confidences);
+
+private:
+    DetectorSettings m_settings;
+    cv::dnn::Net m_net;         // deep neural network instance containing pretrained EAST model
+    EastDecoder m_decoder;      // vectorized decoder (same result as decode())
+    RotatedNms m_nms;           // grid indexed NMS (same result as cv::dnn::NMSBoxes)
+    double m_warmUpMs;
+    double m_lastForwardMs;
+    double m_totalForwardMs;
+    long m_forwardCount;
+};
+
+#endif // TEXTDETECTOR_H
@@ -0,0 +1,160 @@
+// system includes
+#include <algorithm>
+#include <numeric>
+
+// local includes
+#include "TextGrouper.h"
+
+/**
+ * Groups word boxes into larger areas in reading order
+ *
+ * @param boxes detected text areas (after non-maximum suppression)
+ * @param mode how far the boxes are merged
+ * @returns areas in reading order, never more than boxes
+ */
+std::vector<cv::Rect> TextGrouper::group(const std::vector<cv::Rect> &boxes, Mode mode)
+{
+    std::vector<cv::Rect> areas;
+    for (const cv::Rect &box : boxes) {
+        if (!box.empty()) {
+            areas.push_back(box);
+        }
+    }
+
+    if (mode >= Lines) {
+        // duplicates first, so a word counted twice does not widen the line gap check
+        areas = merge(areas, overlapping);
+        areas = merge(areas, sameLine);
+    }
+    if (mode >= Paragraphs) {
+        areas = merge(areas, sameParagraph);
+    }
+    sortReadingOrder(areas);
+    return areas;
+}
+
+/**
+ * Sorts areas top to bottom, areas on the same row left to right
+ * An area belongs to a row if its vertical center lies within the row.
+ *
+ * @param areas to be sorted
+ */
+void TextGrouper::sortReadingOrder(std::vector<cv::Rect> &areas)
+{
+    std::sort(areas.begin(), areas.end(), [](const cv::Rect &a, const cv::Rect &b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+
+    std::vector<cv::Rect> sorted;
+    sorted.reserve(areas.size());
+    size_t rowStart = 0;
+    while (rowStart < areas.size()) {
+        int rowTop = areas[rowStart].y;
+        int rowBottom = areas[rowStart].br().y;
+        size_t rowEnd = rowStart + 1;
+        for (; rowEnd < areas.size(); ++rowEnd) {
+            int center = areas[rowEnd].y + areas[rowEnd].height / 2;
+            if (center < rowTop || center >= rowBottom) {
+                break;
+            }
+            rowBottom = std::max(rowBottom, areas[rowEnd].br().y);
+        }
+        std::sort(areas.begin() + rowStart, areas.begin() + rowEnd, [](const cv::Rect &a, const cv::Rect &b) {
+            return a.x < b.x;
+        });
+        sorted.insert(sorted.end(), areas.begin() + rowStart, areas.begin() + rowEnd);
+        rowStart = rowEnd;
+    }
+    areas.swap(sorted);
+}
+
+/**
+ * Boxes covering mostly the same pixels (e.g. a word found twice)
+ */
+bool TextGrouper::overlapping(const cv::Rect &a, const cv::Rect &b)
+{
+    const int intersection = (a & b).area();
+    return intersection > 0 && intersection * 10 >= std::min(a.area(), b.area()) * 3;
+}
+
+/**
+ * Neighbouring words of a line: similar height, vertically overlapping by at
+ * least half a line and horizontally at most a line height apart
+ */
+bool TextGrouper::sameLine(const cv::Rect &a, const cv::Rect &b)
+{
+    const int minHeight = std::min(a.height, b.height);
+    const int maxHeight = std::max(a.height, b.height);
+    if (maxHeight > 2 * minHeight) {
+        return false;
+    }
+    const int verticalOverlap = std::min(a.br().y, b.br().y) - std::max(a.y, b.y);
+    const int horizontalGap = std::max(a.x, b.x) - std::min(a.br().x, b.br().x);
+    return verticalOverlap * 2 >= minHeight && horizontalGap <= maxHeight;
+}
+
+/**
+ * Consecutive lines of a paragraph: similar height, horizontally overlapping
+ * and less than a line height apart
+ */
+bool TextGrouper::sameParagraph(const cv::Rect &a, const cv::Rect &b)
+{
+    const int minHeight = std::min(a.height, b.height);
+    const int maxHeight = std::max(a.height, b.height);
+    if (maxHeight * 2 > minHeight * 3) {
+        return false;
+    }
+    const int verticalGap = std::max(a.y, b.y) - std::min(a.br().y, b.br().y);
+    const int horizontalOverlap = std::min(a.br().x, b.br().x) - std::max(a.x, b.x);
+    return verticalGap < minHeight && horizontalOverlap > 0;
+}
+
+/**
+ * Replaces all transitively joined rectangles by their union
+ * Repeated until no union joins any other rectangle, as a union may reach
+ * rectangles none of its parts did.
+ *
+ * @param rects to be merged
+ * @param joined whether two rectangles belong to the same group
+ * @returns merged rectangles (unordered)
+ */
+template <typename Predicate>
+std::vector<cv::Rect> TextGrouper::merge(const std::vector<cv::Rect> &rects, Predicate joined)
+{
+    std::vector<cv::Rect> current = rects;
+    for (;;) {
+        // union-find over all pairs, the number of boxes per image is small
+        std::vector<size_t> parent(current.size());
+        std::iota(parent.begin(), parent.end(), 0);
+        auto root = [&parent](size_t i) {
+            while (parent[i] != i) {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        };
+        for (size_t i = 0; i < current.size(); ++i) {
+            for (size_t j = i + 1; j < current.size(); ++j) {
+                if (joined(current[i], current[j])) {
+                    parent[root(j)] = root(i);
+                }
+            }
+        }
+
+        std::vector<cv::Rect> merged;
+        std::vector<int> groupOf(current.size(), -1);
+        for (size_t i = 0; i < current.size(); ++i) {
+            size_t r = root(i);
+            if (groupOf[r] < 0) {
+                groupOf[r] = (int)merged.size();
+                merged.push_back(current[i]);
+            } else {
+                merged[groupOf[r]] |= current[i];
+            }
+        }
+        if (merged.size() == current.size()) {
+            return merged;
+        }
+        current.swap(merged);
+    }
+}
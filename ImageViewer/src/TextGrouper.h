@@ -0,0 +1,48 @@
+/**
+ * @file TextGrouper.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef TEXTGROUPER_H
+#define TEXTGROUPER_H
+
+// system includes
+#include <vector>
+
+// local includes
+#include "opencv2/core.hpp"
+
+/**
+ * Merges the detected word boxes into text lines or paragraphs
+ *
+ * EAST reports mostly single words, often with overlapping boxes. Every box
+ * costs one recognition call with a fixed overhead, and recognizing the
+ * boxes one by one loses the order of the text. TextGrouper joins
+ * overlapping boxes, then boxes of the same line (vertical overlap, small
+ * horizontal gap) and optionally the lines of a paragraph (similar height,
+ * small vertical gap, overlapping columns). The result is sorted in reading
+ * order: top to bottom, left to right within a row.
+ */
+class TextGrouper
+{
+public:
+    enum Mode {
+        Words = 0,          // boxes as detected (only sorted)
+        Lines = 1,
+        Paragraphs = 2
+    };
+
+    static std::vector<cv::Rect> group(const std::vector<cv::Rect> &boxes, Mode mode);
+    static void sortReadingOrder(std::vector<cv::Rect> &areas);
+
+private:
+    static bool overlapping(const cv::Rect &a, const cv::Rect &b);
+    static bool sameLine(const cv::Rect &a, const cv::Rect &b);
+    static bool sameParagraph(const cv::Rect &a, const cv::Rect &b);
+    template <typename Predicate>
+    static std::vector<cv::Rect> merge(const std::vector<cv::Rect> &rects, Predicate joined);
+};
+
+#endif // TEXTGROUPER_H
@@ -0,0 +1,83 @@
+/**
+ * @file TextLayout.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef TEXTLAYOUT_H
+#define TEXTLAYOUT_H
+
+// system includes
+#include <string>
+#include <vector>
+
+// local includes
+#include "opencv2/core.hpp"
+
+/**
+ * Recognized word with its bounding box
+ */
+struct TextWord
+{
+    cv::Rect box;
+    float confidence = 0.0f;        // 0..100
+    std::string text;               // UTF-8
+};
+
+/**
+ * Text line (baseline order of the words)
+ */
+struct TextLine
+{
+    cv::Rect box;
+    float confidence = 0.0f;
+    std::vector<TextWord> words;
+};
+
+/**
+ * Text region: a block found by Tesseract, within a detected area if there was one
+ */
+struct TextBlock
+{
+    cv::Rect box;
+    float confidence = 0.0f;
+    int area = -1;                  // index of the detected text area (-1: whole image)
+    std::vector<TextLine> lines;
+};
+
+/**
+ * Word level result of one page
+ *
+ * All boxes are in pixel coordinates of the original page, i.e. after the
+ * offsets of the detected areas and crops and the preprocessing (scaling,
+ * deskew) have been undone.
+ */
+struct TextPage
+{
+    int index = 0;                  // page of the document
+    cv::Size size;                  // of the original page
+    std::vector<TextBlock> blocks;  // reading order
+};
+
+/**
+ * Applies a mapping to every box of the blocks (e.g. back to the original page)
+ *
+ * @param blocks of a page
+ * @param map function taking and returning a cv::Rect
+ */
+template <typename Map>
+void mapTextBoxes(std::vector<TextBlock> &blocks, Map map)
+{
+    for (TextBlock &block : blocks) {
+        block.box = map(block.box);
+        for (TextLine &line : block.lines) {
+            line.box = map(line.box);
+            for (TextWord &word : line.words) {
+                word.box = map(word.box);
+            }
+        }
+    }
+}
+
+#endif // TEXTLAYOUT_H
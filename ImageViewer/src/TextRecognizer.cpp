@@ -0,0 +1,248 @@
+// local includes
+#include "TextRecognizer.h"
+#include "ModelStore.h"
+#include "Tracer.h"
+#include "tesseract/ocrclass.h"
+#include "tesseract/resultiterator.h"
+
+/**
+ * Passed to the Tesseract progress monitor as cancel context
+ */
+struct MonitorContext
+{
+    ETEXT_DESC *desc;
+    const TextRecognizer::Monitor *monitor;
+    bool cancelled;
+};
+
+TextRecognizer::TextRecognizer() : m_api(nullptr), m_engineMode(tesseract::OEM_DEFAULT),
+    m_pageMode(tesseract::PSM_SINGLE_BLOCK), m_areaMode(tesseract::PSM_SINGLE_BLOCK), m_cancelled(false)
+{
+}
+
+TextRecognizer::~TextRecognizer()
+{
+    // Destroy object to release memory
+    if (m_api != nullptr) {
+        m_api->End();
+        delete m_api;
+    }
+}
+
+/**
+ * Initializes the Tesseract API, again only if the configuration changed
+ *
+ * @param dataPath to the pretrained tessdata directory
+ * @param language of the pretrained data, e.g. "eng"
+ * @param engineMode tesseract::OcrEngineMode (LSTM, legacy or both)
+ * @returns false if tesseract could not be initialized
+ */
+bool TextRecognizer::init(const std::string &dataPath, const std::string &language, int engineMode)
+{
+    if (m_api != nullptr) {
+        if (dataPath == m_dataPath && language == m_language && engineMode == m_engineMode) {
+            return true;
+        }
+        m_api->End();
+        delete m_api;
+        m_api = nullptr;
+    }
+
+    // a single language is initialized from the shared mapping of its traineddata
+    std::shared_ptr<const MappedFile> traineddata;
+    if (language.find('+') == std::string::npos) {
+        traineddata = ModelStore::instance().map(dataPath + "/" + language + ".traineddata");
+    }
+
+    tesseract::TessBaseAPI *api = new tesseract::TessBaseAPI();
+    int error;
+    if (traineddata) {
+        error = api->Init(traineddata->data(), (int)traineddata->size(), language.c_str(),
+            (tesseract::OcrEngineMode)engineMode, nullptr, 0, nullptr, nullptr, false, nullptr);
+    } else {
+        error = api->Init(dataPath.c_str(), language.c_str(), (tesseract::OcrEngineMode)engineMode);
+    }
+    if (error) {
+        delete api;
+        return false;
+    }
+    m_api = api;
+    m_dataPath = dataPath;
+    m_language = language;
+    m_engineMode = engineMode;
+    return true;
+}
+
+/**
+ * Sets the page segmentation modes
+ *
+ * @param pageMode used by recognize() for the whole image
+ * @param areaMode used for single areas (e.g. PSM_SINGLE_LINE for text lines)
+ */
+void TextRecognizer::setPageSegModes(int pageMode, int areaMode)
+{
+    m_pageMode = pageMode;
+    m_areaMode = areaMode;
+}
+
+/**
+ * Passes an image to the Tesseract API, which copies the pixels into its own Pix
+ *
+ * @param image with 8 bit depth and either 1 or 3 channels
+ */
+void TextRecognizer::setImage(const cv::Mat &image)
+{
+    CV_Assert(m_api != nullptr);
+    CV_Assert(image.depth() == CV_8U);
+    m_api->SetImage(image.data, image.cols, image.rows, image.channels(), (int)image.step);
+}
+
+/**
+ * Recognizes the text of the whole image
+ *
+ * @returns recognized text
+ */
+std::string TextRecognizer::recognize()
+{
+    m_api->SetPageSegMode((tesseract::PageSegMode)m_pageMode);
+    return read();
+}
+
+/**
+ * Runs the recognition on the current image or rectangle
+ *
+ * @returns recognized text
+ */
+std::string TextRecognizer::read()
+{
+    m_cancelled = false;
+    if (m_monitor) {
+        // recognize with monitor, GetUTF8Text() then only reads the result
+        ETEXT_DESC desc;
+        MonitorContext context = {&desc, &m_monitor, false};
+        desc.cancel = &TextRecognizer::cancelCallback;
+        desc.cancel_this = &context;
+        if (m_api->Recognize(&desc) < 0 || context.cancelled) {
+            m_cancelled = context.cancelled;
+            return "";
+        }
+    }
+
+    char *outText = m_api->GetUTF8Text();
+    std::string text = outText != nullptr ? outText : "";
+    delete [] outText;
+    return text;
+}
+
+/**
+ * Recognizes the text inside a single area of the image
+ *
+ * @param area in image coordinates
+ * @returns recognized text
+ */
+std::string TextRecognizer::recognize(const cv::Rect &area)
+{
+    m_api->SetPageSegMode((tesseract::PageSegMode)m_areaMode);
+    m_api->SetRectangle(area.x, area.y, area.width, area.height);
+    return read();
+}
+
+/**
+ * Mean confidence of the words of the last recognition
+ *
+ * @returns confidence from 0 to 100
+ */
+int TextRecognizer::meanConfidence() const
+{
+    return m_api != nullptr ? m_api->MeanTextConf() : 0;
+}
+
+/**
+ * Appends the blocks, lines and words of the last recognition
+ * Reads Tesseract's result iterator, nothing is recognized again. The
+ * boxes of a rectangle set by recognize(area) are already in image
+ * coordinates.
+ *
+ * @param blocks to which the result is appended
+ * @param area index stored with the blocks (-1: whole image)
+ * @param offset added to all boxes (e.g. position of a crop in the page)
+ */
+void TextRecognizer::readLayout(std::vector<TextBlock> &blocks, int area, const cv::Point &offset) const
+{
+    if (m_api == nullptr || m_cancelled) {
+        return;
+    }
+    tesseract::ResultIterator *it = m_api->GetIterator();
+    if (it == nullptr) {
+        return;
+    }
+
+    auto boxOf = [it, &offset](tesseract::PageIteratorLevel level) {
+        int left, top, right, bottom;
+        it->BoundingBox(level, &left, &top, &right, &bottom);
+        return cv::Rect(left, top, right - left, bottom - top) + offset;
+    };
+    if (!it->Empty(tesseract::RIL_WORD)) {
+        do {
+            if (it->IsAtBeginningOf(tesseract::RIL_BLOCK) || blocks.empty() || blocks.back().area != area) {
+                TextBlock block;
+                block.box = boxOf(tesseract::RIL_BLOCK);
+                block.confidence = it->Confidence(tesseract::RIL_BLOCK);
+                block.area = area;
+                blocks.push_back(block);
+            }
+            TextBlock &block = blocks.back();
+            if (it->IsAtBeginningOf(tesseract::RIL_TEXTLINE) || block.lines.empty()) {
+                TextLine line;
+                line.box = boxOf(tesseract::RIL_TEXTLINE);
+                line.confidence = it->Confidence(tesseract::RIL_TEXTLINE);
+                block.lines.push_back(line);
+            }
+            char *text = it->GetUTF8Text(tesseract::RIL_WORD);
+            if (text != nullptr) {
+                TextWord word;
+                word.box = boxOf(tesseract::RIL_WORD);
+                word.confidence = it->Confidence(tesseract::RIL_WORD);
+                word.text = text;
+                block.lines.back().words.push_back(word);
+                delete [] text;
+            }
+        } while (it->Next(tesseract::RIL_WORD));
+    }
+    delete it;
+}
+
+/**
+ * Recognizes the text of several areas and concatenates it in the given order
+ *
+ * @param areas in image coordinates
+ * @returns recognized text
+ */
+std::string TextRecognizer::recognize(const std::vector<cv::Rect> &areas)
+{
+    std::string text;
+    for (size_t i = 0; i < areas.size(); ++i) {
+        TraceSpan span("recognize_area", (int)i);
+        text += recognize(areas[i]);
+        if (m_cancelled) {
+            break;
+        }
+    }
+    return text;
+}
+
+/**
+ * Called periodically by Tesseract while recognizing
+ *
+ * @param context of the running recognition
+ * @param words recognized so far
+ * @returns true to cancel the recognition
+ */
+bool TextRecognizer::cancelCallback(void *context, int)
+{
+    MonitorContext *c = static_cast<MonitorContext*>(context);
+    if (!(*c->monitor)(c->desc->progress)) {
+        c->cancelled = true;
+    }
+    return c->cancelled;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file TextRecognizer.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef TEXTRECOGNIZER_H
+#define TEXTRECOGNIZER_H
+
+// system includes
+#include <functional>
+#include <string>
+#include <vector>
+
+// local includes
+#include "TextLayout.h"
+#include "tesseract/baseapi.h"
+#include "opencv2/opencv.hpp"
+
+// path to the pretrained tessdata, can be overridden at configure time
+#ifndef TESSDATA_PATH
+#define TESSDATA_PATH "/home/simon/programs/tesseract/share/tessdata"
+#endif
+
+/**
+ * Optical character recognition using the Tesseract API
+ *
+ * TextRecognizer owns one TessBaseAPI instance. An image is passed once
+ * with setImage() and can then be recognized as a whole or area by area.
+ * Tesseract copies the pixels once per setImage(), the buffer of the
+ * caller does not have to stay valid afterwards. A recognizer is not
+ * thread safe, use one instance per thread. Tesseract requires the "C" locale while initializing.
+ * An optional monitor is called periodically during recognition with
+ * the progress in percent and can cancel a running recognition.
+ * Whole images and single areas use their own page segmentation mode,
+ * e.g. a detected text line is recognized as a single line.
+ * The words, lines and blocks of the last recognition, with their boxes
+ * and confidences, are read from the same pass with readLayout().
+ */
+class TextRecognizer
+{
+public:
+    typedef std::function<bool(int)> Monitor;  // gets progress in percent, returns false to cancel
+
+    TextRecognizer();
+    ~TextRecognizer();
+
+    bool init(const std::string &dataPath = TESSDATA_PATH, const std::string &language = "eng",
+        int engineMode = tesseract::OEM_DEFAULT);
+    bool isInitialized() const { return m_api != nullptr; }
+
+    void setPageSegModes(int pageMode, int areaMode);   // tesseract::PageSegMode of whole images and areas
+    void setImage(const cv::Mat &image);        // 8 bit image with 1 or 3 channels
+    std::string recognize();                    // whole image
+    std::string recognize(const cv::Rect &area);
+    std::string recognize(const std::vector<cv::Rect> &areas);
+
+    void setMonitor(const Monitor &monitor) { m_monitor = monitor; }
+    bool wasCancelled() const { return m_cancelled; }
+    int meanConfidence() const;                 // 0..100 of the last recognition
+    void readLayout(std::vector<TextBlock> &blocks, int area = -1, const cv::Point &offset = cv::Point()) const;
+
+private:
+    TextRecognizer(const TextRecognizer &) = delete;
+    TextRecognizer &operator=(const TextRecognizer &) = delete;
+
+    static bool cancelCallback(void *context, int words);
+    std::string read();
+
+    tesseract::TessBaseAPI *m_api;              // interface to handle ocr
+    std::string m_dataPath;                     // engine configuration of m_api
+    std::string m_language;
+    int m_engineMode;
+    int m_pageMode;
+    int m_areaMode;
+    Monitor m_monitor;
+    bool m_cancelled;                           // last recognition was cancelled by the monitor
+};
+
+#endif // TEXTRECOGNIZER_H
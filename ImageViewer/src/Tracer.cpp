@@ -0,0 +1,220 @@
+// system includes
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+// local includes
+#include "Tracer.h"
+
+/**
+ * Buffer owned by the current thread, handed back to the tracer when the thread exits
+ */
+struct ThreadBuffer
+{
+    Tracer::Buffer *buffer = nullptr;
+
+    ~ThreadBuffer()
+    {
+        if (buffer != nullptr) {
+            Tracer::instance().releaseBuffer(buffer);
+        }
+    }
+};
+
+static thread_local ThreadBuffer s_threadBuffer;
+
+Tracer::Tracer() : m_origin(std::chrono::steady_clock::now()), m_enabled(true)
+{
+}
+
+Tracer &Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+int64_t Tracer::now() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_origin).count();
+}
+
+/**
+ * Sequential id of the calling thread (stable for the lifetime of the thread)
+ */
+int Tracer::threadId()
+{
+    static std::atomic<int> nextId(1);
+    static thread_local int id = nextId++;
+    return id;
+}
+
+/**
+ * Adds a span to the buffer of the calling thread, the oldest span is overwritten when full
+ *
+ * @param name of the span (string literal)
+ * @param start in microseconds (now())
+ * @param duration in microseconds
+ * @param arg shown with the span, -1 if unused
+ */
+void Tracer::record(const char *name, int64_t start, int64_t duration, int arg)
+{
+    if (s_threadBuffer.buffer == nullptr) {
+        s_threadBuffer.buffer = acquireBuffer();
+    }
+    Buffer *buffer = s_threadBuffer.buffer;
+
+    TraceEvent event = { name, start, duration, threadId(), arg };
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    if (buffer->events.size() < CAPACITY) {
+        buffer->events.push_back(event);
+    } else {
+        buffer->events[buffer->next] = event;
+    }
+    buffer->next = (buffer->next + 1) % CAPACITY;
+}
+
+/**
+ * Names the calling thread in the exported trace
+ *
+ * @param name of the thread
+ */
+void Tracer::setThreadName(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threadNames[threadId()] = name;
+}
+
+/**
+ * Total time per kind of span recorded since a point in time
+ *
+ * @param since start of the first span to include (now() before the run)
+ * @returns totals in order of the first occurrence
+ */
+std::vector<StageTotal> Tracer::breakdown(int64_t since) const
+{
+    std::vector<TraceEvent> all = events();
+    std::vector<StageTotal> totals;
+    for (const TraceEvent &event : all) {
+        if (event.start < since) {
+            continue;
+        }
+        auto total = std::find_if(totals.begin(), totals.end(),
+            [&event](const StageTotal &t) { return t.name == event.name; });
+        if (total == totals.end()) {
+            totals.push_back(StageTotal{ event.name, 0.0, 0 });
+            total = totals.end() - 1;
+        }
+        total->ms += event.duration / 1000.0;
+        ++total->count;
+    }
+    return totals;
+}
+
+/**
+ * Short per-stage summary, e.g. "forward 95.1 ms, recognize_area 12x 840.3 ms"
+ *
+ * @param since start of the first span to include
+ */
+std::string Tracer::breakdownText(int64_t since) const
+{
+    std::string text;
+    for (const StageTotal &total : breakdown(since)) {
+        char line[128];
+        if (total.count > 1) {
+            snprintf(line, sizeof(line), "%s %dx %.1f ms", total.name.c_str(), total.count, total.ms);
+        } else {
+            snprintf(line, sizeof(line), "%s %.1f ms", total.name.c_str(), total.ms);
+        }
+        text += (text.empty() ? "" : ", ") + std::string(line);
+    }
+    return text;
+}
+
+/**
+ * Writes all collected spans in the Chrome trace event format
+ *
+ * @param path of the JSON file
+ * @returns false if the file could not be written
+ */
+bool Tracer::writeChromeTrace(const std::string &path) const
+{
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    std::vector<TraceEvent> all = events();
+    std::map<int, std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        names = m_threadNames;
+    }
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const auto &name : names) {
+        out << (first ? "\n" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << name.first << ", \"args\": {\"name\": \"" << name.second << "\"}}";
+        first = false;
+    }
+    for (const TraceEvent &event : all) {
+        out << (first ? "\n" : ",\n") << "{\"name\": \"" << event.name << "\", \"cat\": \"ocr\", \"ph\": \"X\", \"ts\": "
+            << event.start << ", \"dur\": " << event.duration << ", \"pid\": 1, \"tid\": " << event.thread;
+        if (event.arg >= 0) {
+            out << ", \"args\": {\"index\": " << event.arg << "}";
+        }
+        out << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+    return out.good();
+}
+
+/**
+ * Removes all collected spans
+ */
+void Tracer::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+        buffer->next = 0;
+    }
+}
+
+Tracer::Buffer *Tracer::acquireBuffer()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &buffer : m_buffers) {
+        if (!buffer->inUse) {
+            buffer->inUse = true;
+            return buffer.get();
+        }
+    }
+    m_buffers.emplace_back(new Buffer());
+    m_buffers.back()->events.reserve(CAPACITY);
+    m_buffers.back()->inUse = true;
+    return m_buffers.back().get();
+}
+
+void Tracer::releaseBuffer(Buffer *buffer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    buffer->inUse = false;
+}
+
+/**
+ * Copy of the spans of all threads, sorted by start time
+ */
+std::vector<TraceEvent> Tracer::events() const
+{
+    std::vector<TraceEvent> all;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        all.insert(all.end(), buffer->events.begin(), buffer->events.end());
+    }
+    std::sort(all.begin(), all.end(), [](const TraceEvent &a, const TraceEvent &b) { return a.start < b.start; });
+    return all;
+}
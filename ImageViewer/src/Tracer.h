@@ -0,0 +1,123 @@
+/**
+ * @file Tracer.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+// system includes
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * One timed span
+ */
+struct TraceEvent
+{
+    const char *name;           // string literal, never copied
+    int64_t start;              // microseconds since the tracer was created
+    int64_t duration;           // microseconds
+    int thread;                 // sequential id of the recording thread
+    int arg;                    // e.g. index of the text area, -1 if unused
+};
+
+/**
+ * Total time spent in one kind of span
+ */
+struct StageTotal
+{
+    std::string name;
+    double ms;
+    int count;
+};
+
+/**
+ * Lightweight collector of timing spans, exported as Chrome trace
+ *
+ * Spans are recorded with TraceSpan (RAII) into a ring buffer of the
+ * recording thread, so no allocation and no contended lock happens on the
+ * hot path and the memory stays bounded when tracing is left on. The
+ * collected spans can be summarized per stage or written as Chrome trace
+ * JSON, which is loaded by chrome://tracing and ui.perfetto.dev.
+ */
+class Tracer
+{
+public:
+    static Tracer &instance();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    int64_t now() const;        // microseconds since the tracer was created
+    void record(const char *name, int64_t start, int64_t duration, int arg);
+    void setThreadName(const std::string &name);        // name of the calling thread in the trace
+
+    std::vector<StageTotal> breakdown(int64_t since) const;
+    std::string breakdownText(int64_t since) const;
+    bool writeChromeTrace(const std::string &path) const;
+    void clear();
+
+private:
+    struct Buffer {
+        std::mutex mutex;       // only contended while the buffer is read
+        std::vector<TraceEvent> events;
+        size_t next = 0;        // ring position
+        bool inUse = false;     // owned by a running thread
+    };
+
+    Tracer();
+    Buffer *acquireBuffer();
+    void releaseBuffer(Buffer *buffer);
+    std::vector<TraceEvent> events() const;
+    static int threadId();
+
+    friend struct ThreadBuffer;
+
+private:
+    static const size_t CAPACITY = 16384;      // events per buffer
+    const std::chrono::steady_clock::time_point m_origin;
+    std::atomic<bool> m_enabled;
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Buffer>> m_buffers;      // buffers of finished threads are reused
+    std::map<int, std::string> m_threadNames;
+};
+
+/**
+ * Records the lifetime of the object as span of the calling thread
+ */
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name, int arg = -1) : m_name(name), m_arg(arg),
+        m_start(Tracer::instance().isEnabled() ? Tracer::instance().now() : -1)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (m_start >= 0) {
+            Tracer &tracer = Tracer::instance();
+            tracer.record(m_name, m_start, tracer.now() - m_start, m_arg);
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *m_name;
+    const int m_arg;
+    const int64_t m_start;      // -1 if tracing is disabled
+};
+
+#endif // TRACER_H
@@ -0,0 +1,258 @@
+// system includes
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// local includes
+#include "VideoProcessor.h"
+#include "BoundedQueue.h"
+#include "TextGrouper.h"
+#include "Tracer.h"
+#include "opencv2/videoio.hpp"
+
+VideoProcessor::VideoProcessor(const VideoOptions &options) : m_options(options),
+    m_detector(options.engines.detector)
+{
+}
+
+/**
+ * Runs OCR on the sampled frames of the video and writes the time-stamped text
+ *
+ * @returns 0 on success, 1 if the video, the engines or the output failed
+ */
+int VideoProcessor::run()
+{
+    const BatchOptions &engines = m_options.engines;
+    cv::VideoCapture capture(m_options.input.toStdString());
+    if (!capture.isOpened()) {
+        std::cerr << "Can't read video " << m_options.input.toStdString() << std::endl;
+        return 1;
+    }
+
+    const OcrProfile &profile = engines.profile;
+    if (!m_recognizer.init(profile.dataPath(engines.tessdata, engines.language), engines.language,
+            profile.engineMode)) {
+        std::cerr << "Failed to initialize tesseract." << std::endl;
+        return 1;
+    }
+    m_recognizer.setPageSegModes(profile.pageSegMode, profile.areaPageSegModeFor(engines.detector.grouping));
+    if (engines.detectAreas && !m_detector.load()) {
+        std::cerr << "Failed to load " << engines.detector.model << std::endl;
+        return 1;
+    }
+
+    QFile file;
+    if (m_options.output == "-") {
+        file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        QFileInfo info(m_options.input);
+        file.setFileName(m_options.output.isEmpty()
+            ? info.dir().filePath(info.completeBaseName() + ".txt") : m_options.output);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cerr << "Can't save text " << file.fileName().toStdString() << std::endl;
+            return 1;
+        }
+    }
+
+    BoundedQueue<Frame> sampled(PIPELINE_DEPTH);
+    BoundedQueue<Frame> detected(PIPELINE_DEPTH);
+    std::atomic<int> sampleCount(0);
+    std::atomic<int> skipCount(0);
+    std::atomic<bool> modelFailed(false);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // stage 1: frames are decoded at the sampling interval only, unchanged scenes are dropped
+    std::thread sampler([&]() {
+        Tracer::instance().setThreadName("video sampler");
+        const double fps = capture.get(cv::CAP_PROP_FPS);
+        double nextSampleMs = 0.0;
+        cv::Mat bgr;
+        for (int index = 0; ; ++index) {
+            {
+                TraceSpan span("grab_frame", index);
+                if (!capture.grab()) {
+                    break;
+                }
+            }
+            const double timeMs = fps > 0.0 ? index * 1000.0 / fps : capture.get(cv::CAP_PROP_POS_MSEC);
+            if (timeMs < nextSampleMs) {
+                continue;
+            }
+            while (nextSampleMs <= timeMs) {
+                nextSampleMs += m_options.intervalMs;
+            }
+
+            Frame frame;
+            frame.index = index;
+            frame.timeMs = timeMs;
+            {
+                TraceSpan span("decode_frame", index);
+                if (!capture.retrieve(bgr) || bgr.empty()) {
+                    break;
+                }
+                cv::cvtColor(bgr, frame.image, cv::COLOR_BGR2RGB);   // same channel order as the images
+            }
+            ++sampleCount;
+            bool changed;
+            {
+                TraceSpan span("scene_change", index);
+                changed = sceneChanged(frame.image);
+            }
+            if (!changed) {
+                ++skipCount;
+                continue;
+            }
+            if (!sampled.push(std::move(frame))) {
+                break;
+            }
+        }
+        sampled.close();
+    });
+
+    // stage 2: preprocessing and text area detection
+    std::thread detector([&]() {
+        Tracer::instance().setThreadName("video detector");
+        Frame frame;
+        while (sampled.pop(frame)) {
+            frame.frame = frame.image;
+            cv::Mat detectionFrame = frame.image;
+            if (engines.preprocess.enabled) {
+                TraceSpan span("preprocess", frame.index);
+                frame.preprocessed = Preprocessor::process(frame.image, engines.preprocess);
+                detectionFrame = frame.preprocessed.gray;
+                frame.frame = frame.preprocessed.binary;
+            }
+            if (engines.detectAreas) {
+                TraceSpan span("detect", frame.index);
+                if (!m_detector.detect(detectionFrame, frame.areas)) {
+                    modelFailed = true;
+                    break;
+                }
+                frame.areas = TextGrouper::group(frame.areas, (TextGrouper::Mode)engines.detector.grouping);
+            }
+            if (!detected.push(std::move(frame))) {
+                break;
+            }
+        }
+        // wakes up the sampler if the detection stopped early
+        sampled.close();
+        detected.close();
+    });
+
+    // stage 3: recognition and removal of the lines still on screen
+    int frameCount = 0;
+    int lineCount = 0;
+    bool writeFailed = false;
+    Frame frame;
+    while (detected.pop(frame)) {
+        std::string text;
+        {
+            TraceSpan span("recognize", frame.index);
+            m_recognizer.setImage(frame.frame);
+            text = engines.detectAreas ? m_recognizer.recognize(frame.areas) : m_recognizer.recognize();
+        }
+        ++frameCount;
+        const std::string time = timestamp(frame.timeMs);
+        for (const std::string &line : newLines(text)) {
+            const std::string entry = time + '\t' + line + '\n';
+            if (file.write(entry.data(), (qint64)entry.size()) != (qint64)entry.size()) {
+                writeFailed = true;
+            }
+            ++lineCount;
+        }
+        file.flush();
+    }
+    sampler.join();
+    detector.join();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (modelFailed) {
+        std::cerr << "Text area detection failed." << std::endl;
+        return 1;
+    }
+    if (writeFailed) {
+        std::cerr << "Can't save text " << file.fileName().toStdString() << std::endl;
+        return 1;
+    }
+    // stdout may carry the text
+    std::cerr << sampleCount.load() << " frames sampled, " << skipCount.load() << " unchanged skipped, "
+              << frameCount << " recognized, " << lineCount << " lines in " << elapsed.count() << " s" << std::endl;
+    return 0;
+}
+
+/**
+ * Compares a sampled frame with the last processed one
+ * Both are reduced to grayscale thumbnails, pixels differing by more than
+ * a few gray levels count as changed (compression noise does not).
+ *
+ * @param image RGB frame
+ * @returns true if the frame has to be processed, it becomes the new reference then
+ */
+bool VideoProcessor::sceneChanged(const cv::Mat &image)
+{
+    const int height = std::max(1, image.rows * THUMBNAIL_WIDTH / std::max(1, image.cols));
+    cv::Mat small, thumbnail;
+    cv::resize(image, small, cv::Size(THUMBNAIL_WIDTH, height), 0, 0, cv::INTER_AREA);
+    cv::cvtColor(small, thumbnail, cv::COLOR_RGB2GRAY);
+
+    if (m_thumbnail.size() == thumbnail.size()) {
+        cv::Mat difference;
+        cv::absdiff(thumbnail, m_thumbnail, difference);
+        const int changed = cv::countNonZero(difference > CHANGE_LEVEL);
+        if (changed * 100.0 <= m_options.sceneThreshold * thumbnail.total()) {
+            return false;
+        }
+    }
+    m_thumbnail = thumbnail;
+    return true;
+}
+
+/**
+ * Lines of a recognized frame which were not on the previous one
+ * Whitespace is normalized, empty lines and repetitions within the frame are dropped.
+ *
+ * @param text recognized on the frame
+ * @returns new lines in reading order
+ */
+std::vector<std::string> VideoProcessor::newLines(const std::string &text)
+{
+    std::set<std::string> current;
+    std::vector<std::string> lines;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream words(line);
+        std::string word, normalized;
+        while (words >> word) {
+            normalized += (normalized.empty() ? "" : " ") + word;
+        }
+        if (normalized.empty() || !current.insert(normalized).second) {
+            continue;
+        }
+        if (m_previousLines.count(normalized) == 0) {
+            lines.push_back(normalized);
+        }
+    }
+    m_previousLines.swap(current);
+    return lines;
+}
+
+/**
+ * Position in the video as hh:mm:ss.mmm
+ */
+std::string VideoProcessor::timestamp(double ms)
+{
+    const long total = (long)(ms + 0.5);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%02ld:%02ld:%02ld.%03ld", total / 3600000, total / 60000 % 60,
+        total / 1000 % 60, total % 1000);
+    return buffer;
+}
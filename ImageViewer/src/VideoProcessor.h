@@ -0,0 +1,81 @@
+/**
+ * @file VideoProcessor.h
+ * @brief
+ * @author Simon Schweizer
+ *
+ */
+
+#ifndef VIDEOPROCESSOR_H
+#define VIDEOPROCESSOR_H
+
+// system includes
+#include <QString>
+#include <set>
+#include <string>
+#include <vector>
+
+// local includes
+#include "BatchProcessor.h"
+#include "Preprocessor.h"
+#include "TextDetector.h"
+#include "TextRecognizer.h"
+
+/**
+ * Options of the OCR of a video file
+ */
+struct VideoOptions
+{
+    BatchOptions engines;           // pipeline settings (inputs, outputDir and threads are not used)
+    QString input;                  // video file (any format OpenCV can read)
+    QString output;                 // text file, empty: next to the video, "-": stdout
+    int intervalMs = 500;           // time between two sampled frames
+    double sceneThreshold = 0.5;    // percent of changed thumbnail pixels to process a sampled frame
+};
+
+/**
+ * Time-stamped OCR of burned-in captions and on-screen text of a video
+ *
+ * The video is read with cv::VideoCapture and a frame is sampled every
+ * intervalMs. A sampled frame is only processed if it differs from the
+ * last processed one: both are reduced to small grayscale thumbnails and
+ * the share of pixels which changed noticeably has to exceed
+ * sceneThreshold, so static screens and slow fades cost one thumbnail per
+ * sample. Sampling, text area detection and recognition run as pipeline on
+ * three threads, connected by bounded queues. Every text line is written
+ * with the time of the frame it first appeared in; lines which were
+ * already on the previous processed frame are dropped.
+ */
+class VideoProcessor
+{
+public:
+    explicit VideoProcessor(const VideoOptions &options);
+
+    int run();                              // returns the process exit code
+
+private:
+    static const int PIPELINE_DEPTH = 4;    // frames waiting between two stages
+    static const int THUMBNAIL_WIDTH = 256;  // keeps the strokes of caption text visible
+    static const int CHANGE_LEVEL = 16;      // gray levels a thumbnail pixel has to change
+
+    struct Frame {
+        int index = 0;                      // of the frame in the video
+        double timeMs = 0.0;                // position in the video
+        cv::Mat image;                      // RGB
+        PreprocessedFrame preprocessed;
+        cv::Mat frame;                      // input of the recognition (image or preprocessed)
+        std::vector<cv::Rect> areas;
+    };
+
+    bool sceneChanged(const cv::Mat &image);
+    std::vector<std::string> newLines(const std::string &text);
+    static std::string timestamp(double ms);
+
+private:
+    VideoOptions m_options;
+    TextDetector m_detector;
+    TextRecognizer m_recognizer;
+    cv::Mat m_thumbnail;                    // of the last processed frame
+    std::set<std::string> m_previousLines;  // lines of the last processed frame
+};
+
+#endif // VIDEOPROCESSOR_H
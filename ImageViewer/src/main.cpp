@@ -3,17 +3,264 @@
 *   Text extraction GUI application
 *
 *   @author Simon Schweizer
-*   @version 1.3
+*   @version 1.4
 */
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <algorithm>
+#include <clocale>
+#include <cstring>
+#include <iostream>
 #include "MainWindow.h"
+#include "BatchProcessor.h"
+#include "InferenceConfig.h"
+#include "OcrService.h"
+#include "Tracer.h"
+#include "VideoProcessor.h"
+
+/**
+ * Checks if a flag is given on the command line (before the parser exists)
+ */
+static bool hasFlag(int argc, char *argv[], const char *flag)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], flag) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Adds the options of the OCR pipeline shared by the batch mode and the service
+ */
+static void addEngineOptions(QCommandLineParser &parser)
+{
+    parser.addOption({"detect", "Detect text areas prior OCR."});
+    parser.addOption({{"j", "threads"}, "Number of worker threads.", "n",
+                      QString::number(QThread::idealThreadCount())});
+    parser.addOption({"tessdata", "Path to the tessdata directory.", "path", TESSDATA_PATH});
+    parser.addOption({"lang", "Language of the tessdata.", "lang", "eng"});
+    parser.addOption({"tile", "Detect text areas on tiles of this size (multiple of 32, 0: whole frame).", "size", "0"});
+    parser.addOption({"nms-merge", "Merge neighbouring candidate boxes before non-maximum suppression (locality-aware NMS)."});
+    parser.addOption({"scale", "Scaling of the image prior tiled detection.", "factor", "1.0"});
+    parser.addOption({"detect-batch", "Detect up to n images of all workers with one forward pass.", "n", "1"});
+    parser.addOption({"batch-latency", "Longest wait for a detection batch to fill up.", "ms", "20"});
+    parser.addOption({"profile", "Speed/accuracy profile: fast, balanced or best.", "name", "balanced"});
+    parser.addOption({"preprocess", "Grayscale, deskew and binarize the images before detection and OCR."});
+    parser.addOption({"no-deskew", "Preprocess without skew correction."});
+    parser.addOption({"group", "Merge detected boxes into words, lines or paragraphs before OCR (default: by profile).", "mode"});
+    InferenceConfig::addOptions(parser);
+}
+
+/**
+ * Reads the options of the OCR pipeline
+ *
+ * @param parser holding the processed command line
+ * @param options to be filled
+ * @param log receives the chosen configuration
+ * @returns false (after printing the reason) if an option is invalid
+ */
+static bool readEngineOptions(const QCommandLineParser &parser, BatchOptions &options, std::ostream &log = std::cout)
+{
+    options.threads = parser.value("threads").toInt();
+    options.detectAreas = parser.isSet("detect");
+    options.tessdata = parser.value("tessdata").toStdString();
+    options.language = parser.value("lang").toStdString();
+    options.detector.tileSize = parser.value("tile").toInt();
+    options.detector.scale = parser.value("scale").toFloat();
+    options.detector.localityMerge = parser.isSet("nms-merge");
+    options.detectBatch = parser.value("detect-batch").toInt();
+    options.batchLatencyMs = parser.value("batch-latency").toInt();
+    if (!OcrProfile::find(parser.value("profile").toStdString(), options.profile)) {
+        std::cerr << "Unknown profile " << parser.value("profile").toStdString() << std::endl;
+        return false;
+    }
+    options.profile.apply(options.detector, options.preprocess);
+    options.preprocess.enabled = options.profile.preprocess || parser.isSet("preprocess");
+    if (parser.isSet("no-deskew")) {
+        options.preprocess.deskew = false;
+    }
+    const QStringList groupings = {"words", "lines", "paragraphs"};
+    if (parser.isSet("group")) {
+        options.detector.grouping = groupings.indexOf(parser.value("group"));
+        if (options.detector.grouping < 0) {
+            std::cerr << "Unknown grouping " << parser.value("group").toStdString() << std::endl;
+            return false;
+        }
+    }
+    QString error;
+    if (!InferenceConfig::apply(parser, options.detector, error)) {
+        std::cerr << error.toStdString() << std::endl;
+        return false;
+    }
+    log << "profile " << options.profile.name << ", "
+        << InferenceConfig::describe(options.detector).toStdString() << std::endl;
+    return true;
+}
+
+/**
+ * Runs OCR on the images given on the command line without any window
+ */
+static int runBatch(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless batch OCR");
+    parser.addHelpOption();
+    parser.addPositionalArgument("inputs", "Image files, directories or text files listing images.", "inputs...");
+    parser.addOption({"batch", "Run in headless batch mode."});
+    parser.addOption({{"o", "output"}, "Directory for the text files (default: next to the images).", "dir"});
+    parser.addOption({"format", "Output: txt, json or hocr (word boxes and confidences).", "format", "txt"});
+    parser.addOption({"trace", "Write the timing spans of all stages as Chrome trace JSON.", "file"});
+    addEngineOptions(parser);
+    parser.process(app);
+
+    BatchOptions options;
+    options.inputs = parser.positionalArguments();
+    options.outputDir = parser.value("output");
+    options.format = parser.value("format");
+    if (options.inputs.isEmpty()) {
+        parser.showHelp(1);
+    }
+    if (!QStringList({"txt", "json", "hocr"}).contains(options.format)) {
+        std::cerr << "Unknown format " << options.format.toStdString() << std::endl;
+        return 1;
+    }
+    if (!readEngineOptions(parser, options)) {
+        return 1;
+    }
+
+    // tesseract requires the "C" locale
+    setlocale(LC_ALL, "C");
+
+    BatchProcessor processor(options);
+    int result = processor.run();
+
+    std::cout << "stages: " << Tracer::instance().breakdownText(0) << std::endl;
+    if (parser.isSet("trace") && !Tracer::instance().writeChromeTrace(parser.value("trace").toStdString())) {
+        std::cerr << "Can't write trace " << parser.value("trace").toStdString() << std::endl;
+        return 1;
+    }
+    return result;
+}
+
+/**
+ * Runs the local OCR service until the process is terminated
+ */
+static int runService(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local OCR service");
+    parser.addHelpOption();
+    parser.addOption({"serve", "Run as local OCR service."});
+    parser.addOption({"socket", "Unix domain socket to listen on (empty: none).", "path", "/tmp/imageviewer-ocr.sock"});
+    parser.addOption({"port", "HTTP port on localhost to listen on (0: none).", "port", "0"});
+    parser.addOption({"max-queue", "Requests waiting beyond that are refused with 503.", "n", "64"});
+    addEngineOptions(parser);
+    parser.process(app);
+
+    ServiceOptions options;
+    options.socketPath = parser.value("socket");
+    options.port = (quint16)parser.value("port").toUInt();
+    options.maxQueue = std::max(1, parser.value("max-queue").toInt());
+    if (!readEngineOptions(parser, options.engines)) {
+        return 1;
+    }
+    if (!parser.isSet("detect-batch")) {
+        // concurrent requests are the normal case of the service
+        options.engines.detectBatch = 4;
+    }
+
+    // tesseract requires the "C" locale
+    setlocale(LC_ALL, "C");
+
+    OcrService service(options);
+    if (!service.start()) {
+        return 1;
+    }
+    return app.exec();
+}
+
+/**
+ * Runs OCR on the frames of a video file and writes the time-stamped text
+ */
+static int runVideo(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless video OCR");
+    parser.addHelpOption();
+    parser.addPositionalArgument("video", "Video file (any format OpenCV can read).", "video");
+    parser.addOption({"video", "Run OCR on a video file."});
+    parser.addOption({{"o", "output"}, "Text file (default: next to the video, -: stdout).", "file"});
+    parser.addOption({"interval", "Time between two sampled frames.", "ms", "500"});
+    parser.addOption({"scene-threshold", "Changed pixels (percent) for a sampled frame to be processed.", "percent", "0.5"});
+    parser.addOption({"trace", "Write the timing spans of all stages as Chrome trace JSON.", "file"});
+    addEngineOptions(parser);
+    parser.process(app);
+
+    VideoOptions options;
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+    options.input = parser.positionalArguments().first();
+    options.output = parser.value("output");
+    options.intervalMs = std::max(1, parser.value("interval").toInt());
+    options.sceneThreshold = parser.value("scene-threshold").toDouble();
+    if (!readEngineOptions(parser, options.engines, std::cerr)) {
+        return 1;
+    }
+
+    // tesseract requires the "C" locale
+    setlocale(LC_ALL, "C");
+
+    VideoProcessor processor(options);
+    int result = processor.run();
+
+    std::cerr << "stages: " << Tracer::instance().breakdownText(0) << std::endl;
+    if (parser.isSet("trace") && !Tracer::instance().writeChromeTrace(parser.value("trace").toStdString())) {
+        std::cerr << "Can't write trace " << parser.value("trace").toStdString() << std::endl;
+        return 1;
+    }
+    return result;
+}
 
 int main(int argc, char *argv[])
 {
+    if (hasFlag(argc, argv, "--batch")) {
+        return runBatch(argc, argv);
+    }
+    if (hasFlag(argc, argv, "--serve")) {
+        return runService(argc, argv);
+    }
+    if (hasFlag(argc, argv, "--video")) {
+        return runVideo(argc, argv);
+    }
+
     QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    InferenceConfig::addOptions(parser);
+    parser.process(app);
+    DetectorSettings settings;
+    QString error;
+    if (!InferenceConfig::apply(parser, settings, error)) {
+        std::cerr << error.toStdString() << std::endl;
+        return 1;
+    }
+
     MainWindow window;
-    window.setWindowTitle("ImageViewer V1.3 - OCR");
+    window.setWindowTitle("ImageViewer V1.4 - OCR");
+    window.setDetectorSettings(settings);
+    window.statusBar()->showMessage(InferenceConfig::describe(settings));
 
     // start application
     window.show();